@@ -2,6 +2,8 @@
 
 #include "../videoplayer/VideoPlayer.hpp"
 
+#include <memory>
+
 CommandHandler GetplayCommandHandler() {
     return CommandHandler{
         "play",
@@ -11,6 +13,11 @@ CommandHandler GetplayCommandHandler() {
                        "Options:\n"
                        "  -b\tRun in benchmark mode (no video output) | Default: off\n"
                        "  -bdb\tBlit frames even in benchmark mode | Default: off\n"
+                       "  -dlcd\tDecode directly into the LCD buffer, pre-rotated video or -rot only | Default: off\n"
+                       "  -rot\tRotate 320x240 video during color conversion instead of using the magic framebuffer | Default: off\n"
+                       "  -fs\tDrop late frames to catch up | Default: on\n"
+                       "  -fst\tShow the first frame before decoding ahead | Default: on\n"
+                       "  -sl\tColor convert each macroblock row right after decoding it | Default: on\n"
                        "  -fd\tFast decoding (less CPU usage, lower quality) | Default: on\n"
                        "  -ld\tLow-delay mode (reduces latency, disables B-frames) | Default: off\n"
                        "  -dbl\tEnable luma deblocking filter | Default: off\n"
@@ -33,6 +40,16 @@ CommandHandler GetplayCommandHandler() {
                     options.benchmarkMode = true;
                 } else if (args[i] == "-bdb") {
                     options.blitDuringBenchmark = true;
+                } else if (args[i] == "-dlcd") {
+                    options.renderDirectToLCD = true;
+                } else if (args[i] == "-rot") {
+                    options.rotateOnConversion = true;
+                } else if (args[i] == "-fs") {
+                    options.frameDropping = true;
+                } else if (args[i] == "-fst") {
+                    options.fastStart = true;
+                } else if (args[i] == "-sl") {
+                    options.sliceOutput = true;
                 } else if (args[i] == "-fd") {
                     options.fastDecoding = true;
                 } else if (args[i] == "-ld") {
@@ -49,6 +66,16 @@ CommandHandler GetplayCommandHandler() {
                     options.benchmarkMode = false;
                 } else if (args[i] == "-Nbdb") {
                     options.blitDuringBenchmark = false;
+                } else if (args[i] == "-Ndlcd") {
+                    options.renderDirectToLCD = false;
+                } else if (args[i] == "-Nrot") {
+                    options.rotateOnConversion = false;
+                } else if (args[i] == "-Nfs") {
+                    options.frameDropping = false;
+                } else if (args[i] == "-Nfst") {
+                    options.fastStart = false;
+                } else if (args[i] == "-Nsl") {
+                    options.sliceOutput = false;
                 } else if (args[i] == "-Nfd") {
                     options.fastDecoding = false;
                 } else if (args[i] == "-Nld") {
@@ -66,14 +93,15 @@ CommandHandler GetplayCommandHandler() {
                 }
             }
 
-            VideoPlayer videoPlayer(options);
-            if (videoPlayer.failed()) {
-                return "play: Error configuring VideoPlayer: " + videoPlayer.getErrorMessage();
+            // on the heap, the profiling histograms make the player too big for the stack
+            auto videoPlayer = std::make_unique<VideoPlayer>(options);
+            if (videoPlayer->failed()) {
+                return "play: Error configuring VideoPlayer: " + videoPlayer->getErrorMessage();
             }
 
-            videoPlayer.play();
-            if (videoPlayer.failed()) {
-                return "play: Error during playback: " + videoPlayer.getErrorMessage() + "\n" + videoPlayer.dumpState();
+            videoPlayer->play();
+            if (videoPlayer->failed()) {
+                return "play: Error during playback: " + videoPlayer->getErrorMessage() + "\n" + videoPlayer->dumpState();
             }
 
             return "";
@@ -54,10 +54,12 @@ class SwapChain {
     RingBuffer<size_t, Count> availableIndices;
 
     void initializeAvailableIndices() {
-        // reset ring buffer to empty then push all indices
+        // reset ring buffer to empty then push all indices, null entries are never handed out
         availableIndices = RingBuffer<size_t, Count>();
         for (size_t i = 0; i < Count; ++i) {
-            availableIndices.push(i);
+            if (buffers[i]) {
+                availableIndices.push(i);
+            }
         }
     }
 
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Header-only so the host tools (tools/decbench.cpp) report in the same format as dumpState().
+// short_stats(std::vector) is exact and meant for the host, the player records into
+// Histogram so its memory use doesn't grow with the length of the video.
+namespace stats
+{
+    namespace detail
+    {
+        template <class T>
+        inline double median_sorted_slice(const std::vector<T>& v, std::size_t lo, std::size_t hi)
+        {
+            const std::size_t len = hi - lo;
+            if (len == 0) return 0.0;
+
+            const std::size_t mid = lo + len / 2;
+            if (len % 2 == 1) {
+                return static_cast<double>(v[mid]);
+            } else {
+                const T a = v[mid - 1];
+                const T b = v[mid];
+                return (static_cast<double>(a) + static_cast<double>(b)) / 2.0;
+            }
+        }
+
+        inline std::string fmt_quart(double x)
+        {
+            // With integral input and Tukey hinges, quartiles/median are integral or end in .5.
+            const double r = std::round(x);
+            if (std::abs(x - r) < 1e-9) {
+                std::ostringstream t;
+                t << static_cast<std::int64_t>(r);
+                return t.str();
+            }
+            std::ostringstream t;
+            t.setf(std::ios::fixed);
+            t.precision(1);
+            t << x;
+            return t.str();
+        }
+    } // namespace detail
+
+    // Very short summary: "min/Q1/med/Q3/max μ=mean"
+    // Quartiles use Tukey hinges (median of halves).
+    template <class T>
+    std::string short_stats(const std::vector<T>& data)
+    {
+        if (data.empty()) return "n=0";
+
+        std::vector<T> v = data;
+        std::sort(v.begin(), v.end());
+
+        const std::size_t n = v.size();
+        const T minv = v.front();
+        const T maxv = v.back();
+
+        const double med = detail::median_sorted_slice(v, 0, n);
+
+        // Split into lower/upper halves (exclude median element when n is odd).
+        const std::size_t half = n / 2;
+        const double q1 = detail::median_sorted_slice(v, 0, half);
+        const double q3 = detail::median_sorted_slice(v, (n % 2 == 0) ? half : (half + 1), n);
+
+        // Mean in double; start at 0.0 to avoid integer overflow during accumulation.
+        const double mean = std::accumulate(v.begin(), v.end(), 0.0) / static_cast<double>(n);
+
+        std::ostringstream oss;
+        oss << minv << '/'
+            << detail::fmt_quart(q1) << '/'
+            << detail::fmt_quart(med) << '/'
+            << detail::fmt_quart(q3) << '/'
+            << maxv
+            << " u="; // 
+
+        oss.setf(std::ios::fixed);
+        oss.precision(2);
+        oss << mean;
+        oss << " n=" << data.size();
+
+        return oss.str();
+    }
+
+    // Streaming histogram with log-spaced buckets: values below 2^SubBucketBits get a bucket each,
+    // above that every power of two is split into 2^SubBucketBits buckets, so a bucket is at most
+    // 1/8th of its value wide. Fixed size, add() is O(1), min/max/mean are exact and quantiles are
+    // interpolated within their bucket. Signed types keep a mirrored set of buckets for negatives.
+    template <class T>
+    class Histogram
+    {
+        static_assert(std::is_integral_v<T> && sizeof(T) <= sizeof(std::uint32_t), "32 bit integers only");
+
+    public:
+        static constexpr unsigned SubBucketBits = 3;
+        static constexpr unsigned SubBuckets = 1u << SubBucketBits;
+        static constexpr unsigned BucketCount = (32 - SubBucketBits + 1) * SubBuckets;
+
+        void add(T value)
+        {
+            if (this->samples == 0 || value < this->minValue) this->minValue = value;
+            if (this->samples == 0 || value > this->maxValue) this->maxValue = value;
+            this->samples++;
+            this->total += value;
+
+            if constexpr (std::is_signed_v<T>) {
+                if (value < 0) {
+                    this->negative[bucket_of(0u - static_cast<std::uint32_t>(value))]++;
+                    return;
+                }
+            }
+            this->positive[bucket_of(static_cast<std::uint32_t>(value))]++;
+        }
+
+        std::uint32_t count() const { return this->samples; }
+        T min() const { return this->minValue; }
+        T max() const { return this->maxValue; }
+        std::int64_t sum() const { return this->total; }
+        double mean() const { return this->samples ? static_cast<double>(this->total) / this->samples : 0.0; }
+
+        std::uint32_t countNegative() const
+        {
+            if constexpr (std::is_signed_v<T>) {
+                return std::accumulate(this->negative.begin(), this->negative.end(), 0u);
+            }
+            return 0;
+        }
+
+        // p in [0, 1], approximate
+        double quantile(double p) const
+        {
+            if (this->samples == 0) return 0.0;
+
+            // 0-based rank of the wanted sample, walk the buckets in value order until it is reached
+            const double rank = p * (this->samples - 1);
+            double below = 0.0;
+            if constexpr (std::is_signed_v<T>) {
+                for (unsigned b = BucketCount; b-- > 0;) {
+                    const std::uint32_t n = this->negative[b];
+                    if (n != 0 && rank < below + n) {
+                        // magnitudes decrease through the bucket
+                        return clamp(-position_in_bucket(b, n - 1 - (rank - below), n));
+                    }
+                    below += n;
+                }
+            }
+            for (unsigned b = 0; b < BucketCount; b++) {
+                const std::uint32_t n = this->positive[b];
+                if (n != 0 && rank < below + n) {
+                    return clamp(position_in_bucket(b, rank - below, n));
+                }
+                below += n;
+            }
+            return static_cast<double>(this->maxValue);
+        }
+
+    private:
+        static unsigned bucket_of(std::uint32_t magnitude)
+        {
+            if (magnitude < SubBuckets) return magnitude;
+            const unsigned log2 = 31 - __builtin_clz(magnitude);
+            return (log2 - SubBucketBits + 1) * SubBuckets + ((magnitude >> (log2 - SubBucketBits)) & (SubBuckets - 1));
+        }
+        static double bucket_low(unsigned bucket)
+        {
+            if (bucket < SubBuckets) return bucket;
+            const unsigned shift = bucket / SubBuckets - 1;
+            return std::ldexp(static_cast<double>(SubBuckets + bucket % SubBuckets), shift);
+        }
+        static double bucket_width(unsigned bucket)
+        {
+            return bucket < SubBuckets ? 1.0 : std::ldexp(1.0, bucket / SubBuckets - 1);
+        }
+        // spread the n samples of a bucket evenly over its range, buckets of width 1 are exact
+        static double position_in_bucket(unsigned bucket, double rankInBucket, std::uint32_t n)
+        {
+            const double width = bucket_width(bucket);
+            return bucket_low(bucket) + (width > 1.0 ? width * (rankInBucket + 0.5) / n : 0.0);
+        }
+        double clamp(double x) const
+        {
+            return std::clamp(x, static_cast<double>(this->minValue), static_cast<double>(this->maxValue));
+        }
+
+        std::array<std::uint32_t, BucketCount> positive{};
+        std::array<std::uint32_t, std::is_signed_v<T> ? BucketCount : 0> negative{};
+        std::uint32_t samples = 0;
+        std::int64_t total = 0;
+        T minValue = 0;
+        T maxValue = 0;
+    };
+
+    // Same "min/Q1/med/Q3/max u=mean n=count" line as short_stats(std::vector), the quartiles are
+    // rounded since they are only accurate to the bucket width.
+    template <class T>
+    std::string short_stats(const Histogram<T>& h)
+    {
+        if (h.count() == 0) return "n=0";
+
+        std::ostringstream oss;
+        oss << h.min() << '/'
+            << std::llround(h.quantile(0.25)) << '/'
+            << std::llround(h.quantile(0.5)) << '/'
+            << std::llround(h.quantile(0.75)) << '/'
+            << h.max()
+            << " u=";
+
+        oss.setf(std::ios::fixed);
+        oss.precision(2);
+        oss << h.mean();
+        oss << " n=" << h.count();
+
+        return oss.str();
+    }
+
+} // namespace stats
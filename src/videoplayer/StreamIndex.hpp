@@ -0,0 +1,344 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+// MPEG-4 Part 2 header parsing shared by the player and the host tools (tools/mkindex.cpp),
+// and the seek index sidecar format. Header-only, no ndless dependencies.
+
+#define VOL_START_CODE_MIN 0x20
+#define VOL_START_CODE_MAX 0x2F
+#define VOP_START_CODE_BYTE 0xB6
+
+// vop_coding_type
+enum : uint8_t { VOP_CODING_I = 0, VOP_CODING_P = 1, VOP_CODING_B = 2, VOP_CODING_S = 3 };
+
+typedef struct {
+    int      ok;      // 1 if parsed
+    uint16_t R;       // vop_time_increment_resolution (ticks/sec)
+    uint8_t  fixed;   // fixed_vop_rate
+    uint16_t inc;     // fixed_vop_time_increment (ticks/frame) if fixed
+    uint8_t  inc_bits;
+
+    // Optional geometry (rectangular only)
+    uint16_t width;
+    uint16_t height;
+} vol_timing_t;
+
+/* --- tiny MSB-first bitreader with 64-bit cache --- */
+typedef struct {
+    const uint8_t *p, *end;
+    uint64_t cache;
+    int bits; // number of valid bits in cache
+} br_t;
+
+static inline void br_fill(br_t *br) {
+    while (br->bits <= 56 && br->p < br->end) {
+        br->cache = (br->cache << 8) | (uint64_t)(*br->p++);
+        br->bits += 8;
+    }
+}
+
+static inline int br_need(br_t *br, int n) {
+    br_fill(br);
+    return br->bits >= n;
+}
+
+static inline uint32_t br_get(br_t *br, int n) {
+    int shift = br->bits - n;
+    uint32_t out;
+    if (n == 32) out = (uint32_t)(br->cache >> shift);
+    else out = (uint32_t)((br->cache >> shift) & ((1u << n) - 1u));
+    br->bits -= n;
+    return out;
+}
+
+static inline int time_inc_bits(uint16_t R) {
+    // bits needed to represent [0..R-1]
+    if (R <= 1) return 1;
+    uint32_t v = (uint32_t)R - 1;
+    int b = 0;
+    while (v) { ++b; v >>= 1; }
+    return b ? b : 1;
+}
+
+// Strictly consume a marker_bit; returns 0 if unavailable.
+static inline int br_marker(br_t *br) {
+    if (!br_need(br, 1)) return 0;
+    (void)br_get(br, 1); // spec says it should be '1'; we don't enforce to be tolerant
+    return 1;
+}
+
+/*
+ * Parse VOL payload that starts immediately AFTER "00 00 01 2x".
+ * payload_len should extend through the VOL header (typically until next startcode).
+ * parse_wh: if nonzero, also parses width/height for rectangular shape.
+ */
+static inline vol_timing_t parse_vol_timing(const uint8_t *payload, size_t payload_len, int parse_wh) {
+    vol_timing_t out = {};
+    br_t br = { payload, payload + payload_len, 0, 0 };
+
+    uint32_t verid = 1; // default when is_object_layer_identifier == 0
+
+    // random_accessible_vol (1)
+    if (!br_need(&br, 1)) return out;
+    (void)br_get(&br, 1);
+
+    // video_object_type_indication (8)
+    if (!br_need(&br, 8)) return out;
+    (void)br_get(&br, 8);
+
+    // is_object_layer_identifier (1)
+    if (!br_need(&br, 1)) return out;
+    uint32_t olid = br_get(&br, 1);
+    if (olid) {
+        // video_object_layer_verid (4)
+        if (!br_need(&br, 4)) return out;
+        verid = br_get(&br, 4);
+
+        // video_object_layer_priority (3)
+        if (!br_need(&br, 3)) return out;
+        (void)br_get(&br, 3);
+    }
+
+    // aspect_ratio_info (4)
+    if (!br_need(&br, 4)) return out;
+    uint32_t ar = br_get(&br, 4);
+    if (ar == 15) {
+        // par_width (8) + par_height (8)
+        if (!br_need(&br, 16)) return out;
+        (void)br_get(&br, 16);
+    }
+
+    // vol_control_parameters (1)
+    if (!br_need(&br, 1)) return out;
+    uint32_t vcp = br_get(&br, 1);
+    if (vcp) {
+        // chroma_format (2)
+        if (!br_need(&br, 2)) return out;
+        (void)br_get(&br, 2);
+
+        // low_delay (1)
+        if (!br_need(&br, 1)) return out;
+        (void)br_get(&br, 1);
+
+        // vbv_parameters (1)
+        if (!br_need(&br, 1)) return out;
+        uint32_t vbv = br_get(&br, 1);
+        if (vbv) {
+            // first_half_bit_rate (15), marker, latter_half_bit_rate (15), marker
+            if (!br_need(&br, 15)) return out;
+            (void)br_get(&br, 15);
+            if (!br_marker(&br)) return out;
+            if (!br_need(&br, 15)) return out;
+            (void)br_get(&br, 15);
+            if (!br_marker(&br)) return out;
+
+            // first_half_vbv_buffer_size (15), marker, latter_half_vbv_buffer_size (3), marker
+            if (!br_need(&br, 15)) return out;
+            (void)br_get(&br, 15);
+            if (!br_marker(&br)) return out;
+            if (!br_need(&br, 3)) return out;
+            (void)br_get(&br, 3);
+            if (!br_marker(&br)) return out;
+
+            // first_half_vbv_occupancy (11), marker, latter_half_vbv_occupancy (15), marker
+            if (!br_need(&br, 11)) return out;
+            (void)br_get(&br, 11);
+            if (!br_marker(&br)) return out;
+            if (!br_need(&br, 15)) return out;
+            (void)br_get(&br, 15);
+            if (!br_marker(&br)) return out;
+        }
+    }
+
+    // video_object_layer_shape (2)
+    if (!br_need(&br, 2)) return out;
+    uint32_t shape = br_get(&br, 2);
+
+    // video_object_layer_shape_extension (4) only if grayscale (shape==3) AND verid != 1
+    if (shape == 3 && verid != 1) {
+        if (!br_need(&br, 4)) return out;
+        (void)br_get(&br, 4);
+    }
+
+    // marker_bit (1)
+    if (!br_marker(&br)) return out;
+
+    // vop_time_increment_resolution (16)
+    if (!br_need(&br, 16)) return out;
+    out.R = (uint16_t)br_get(&br, 16);
+    out.inc_bits = (uint8_t)time_inc_bits(out.R);
+
+    // marker_bit (1)
+    if (!br_marker(&br)) return out;
+
+    // fixed_vop_rate (1)
+    if (!br_need(&br, 1)) return out;
+    out.fixed = (uint8_t)br_get(&br, 1);
+
+    if (out.fixed) {
+        if (!br_need(&br, out.inc_bits)) return out;
+        out.inc = (uint16_t)br_get(&br, out.inc_bits);
+    }
+
+    // Optional: width/height if rectangular shape (shape==0)
+    if (parse_wh && shape == 0) {
+        // marker, width(13), marker, height(13), marker
+        if (!br_marker(&br)) return out;
+        if (!br_need(&br, 13)) return out;
+        out.width = (uint16_t)br_get(&br, 13);
+        if (!br_marker(&br)) return out;
+        if (!br_need(&br, 13)) return out;
+        out.height = (uint16_t)br_get(&br, 13);
+        if (!br_marker(&br)) return out;
+    }
+
+    out.ok = (out.R != 0);
+    return out;
+}
+
+static inline size_t findVOLStartCode(const uint8_t* p, size_t n) {
+    // looks for 00 00 01 2x where x is 0..F
+    if (n < 4) return (size_t)-1;
+    for (size_t i = 0; i + 3 < n; ++i) {
+        if (p[i] == 0x00 && p[i+1] == 0x00 && p[i+2] == 0x01) {
+            uint8_t code = p[i+3];
+            if (code >= VOL_START_CODE_MIN && code <= VOL_START_CODE_MAX) return i;
+        }
+    }
+    return (size_t)-1;
+}
+
+typedef struct {
+    int      ok;            // 1 if parsed
+    uint8_t  coding_type;   // vop_coding_type, I_VOP..S_VOP
+    uint32_t modulo_time;   // modulo_time_base, whole seconds since the previous I/P/S-VOP
+    uint32_t increment;     // vop_time_increment
+} vop_timing_t;
+
+/*
+ * Parse the start of a VOP header, payload starts immediately AFTER "00 00 01 B6".
+ * inc_bits comes from the VOL (vol_timing_t::inc_bits).
+ */
+static inline vop_timing_t parse_vop_timing(const uint8_t *payload, size_t payload_len, int inc_bits) {
+    vop_timing_t out = {0, 0, 0, 0};
+    br_t br = { payload, payload + payload_len, 0, 0 };
+
+    // vop_coding_type (2)
+    if (!br_need(&br, 2)) return out;
+    out.coding_type = (uint8_t)br_get(&br, 2);
+
+    // modulo_time_base, a '1' per elapsed second then a '0'
+    for (;;) {
+        if (!br_need(&br, 1)) return out;
+        if (!br_get(&br, 1)) break;
+        out.modulo_time++;
+    }
+
+    // marker_bit (1), vop_time_increment (inc_bits)
+    if (!br_marker(&br)) return out;
+    if (!br_need(&br, inc_bits)) return out;
+    out.increment = br_get(&br, inc_bits);
+
+    out.ok = 1;
+    return out;
+}
+
+/*
+ * I-VOP start code scan for seeking without an index: 00 00 01 B6 followed by a byte whose
+ * top two bits (vop_coding_type) are 0. A start code can only begin in a 32-bit word that has
+ * a zero byte, and compressed data rarely has one, so the scan loads whole aligned words and
+ * only looks at single bytes when the zero byte test hits. Positions are only reported when
+ * all 5 bytes are in [begin, end), callers overlap consecutive chunks by 4 bytes.
+ */
+static inline int word_has_zero_byte(uint32_t w) {
+    return ((w - 0x01010101u) & ~w & 0x80808080u) != 0;
+}
+
+static inline uint32_t load_aligned_word(const uint8_t *p) {
+    uint32_t w;
+    memcpy(&w, __builtin_assume_aligned(p, 4), 4);
+    return w;
+}
+
+static inline int is_ivop_start_code(const uint8_t *p) {
+    return p[0] == 0x00 && p[1] == 0x00 && p[2] == 0x01 && p[3] == VOP_START_CODE_BYTE &&
+        (p[4] >> 6) == VOP_CODING_I;
+}
+
+// first I-VOP start code in [begin, end), NULL if there is none
+static inline const uint8_t *findNextIVOPStartCode(const uint8_t *begin, const uint8_t *end) {
+    if (end - begin < 5) return NULL;
+    const size_t last = (size_t)(end - begin) - 5;
+    size_t i = 0;
+    for (; i <= last && ((uintptr_t)(begin + i) & 3); i++) {
+        if (is_ivop_start_code(begin + i)) return begin + i;
+    }
+    for (; i <= last; i += 4) {
+        if (!word_has_zero_byte(load_aligned_word(begin + i))) continue;
+        for (size_t j = i; j < i + 4 && j <= last; j++) {
+            if (is_ivop_start_code(begin + j)) return begin + j;
+        }
+    }
+    return NULL;
+}
+
+// last I-VOP start code in [begin, end), NULL if there is none
+static inline const uint8_t *findPrevIVOPStartCode(const uint8_t *begin, const uint8_t *end) {
+    if (end - begin < 5) return NULL;
+    // positions >= i are done
+    size_t i = (size_t)(end - begin) - 4;
+    while (i > 0 && ((uintptr_t)(begin + i) & 3)) {
+        i--;
+        if (is_ivop_start_code(begin + i)) return begin + i;
+    }
+    while (i >= 4) {
+        i -= 4;
+        if (!word_has_zero_byte(load_aligned_word(begin + i))) continue;
+        for (size_t j = i + 4; j-- > i;) {
+            if (is_ivop_start_code(begin + j)) return begin + j;
+        }
+    }
+    while (i > 0) {
+        i--;
+        if (is_ivop_start_code(begin + i)) return begin + i;
+    }
+    return NULL;
+}
+
+/*
+ * Seek index sidecar, <video>.idx.tns next to <video>.tns (see SeekIndexPathFor).
+ * Little endian: a SeekIndexHeader followed by entryCount SeekIndexEntry, one per I-VOP
+ * in file order. Built on the host by tools/mkindex.cpp.
+ */
+#define SEEK_INDEX_MAGIC 0x58495653u // "SVIX"
+#define SEEK_INDEX_VERSION 1
+
+struct SeekIndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t timeIncrementResolution; // of the VOL the time stamps are in, must match the video
+    uint32_t entryCount;
+};
+
+struct SeekIndexEntry {
+    uint32_t byteOffset;  // of the I-VOP start code
+    uint32_t timingTicks; // time_base * timeIncrementResolution + vop_time_increment, counted from the first VOP
+};
+
+static_assert(sizeof(SeekIndexHeader) == 16 && sizeof(SeekIndexEntry) == 8, "seek index layout is part of the file format");
+
+// video.tns -> video.idx.tns, anything else gets .idx.tns appended.
+// files on the calculator need the .tns extension to be transferred
+inline std::string SeekIndexPathFor(const std::string& videoPath) {
+    const std::string extension = ".tns";
+    if (videoPath.size() > extension.size() &&
+        videoPath.compare(videoPath.size() - extension.size(), extension.size(), extension) == 0) {
+        return videoPath.substr(0, videoPath.size() - extension.size()) + ".idx.tns";
+    }
+    return videoPath + ".idx.tns";
+}
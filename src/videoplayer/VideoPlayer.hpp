@@ -11,17 +11,37 @@
 #include <nspire-utils/devices/SP804.hpp>
 
 #include "RingBuffer.hpp"
+#include "Statistics.hpp"
+#include "StreamIndex.hpp"
 
 
 #define SIZEOF_RGB565 2
 #define FILE_READ_BUFFER_PADDING 32
-#define SIZEOF_FILE_READ_BUFFER (262144ul - FILE_READ_BUFFER_PADDING)
+#define FILE_READ_BUFFER_COUNT 2 // read-ahead ring, the decoder consumes one buffer while the next ones are filled
+#define SIZEOF_FILE_READ_BUFFER 131072ul // file data per buffer, together as much read-ahead as the single buffer the ring replaced
+// room in front of each buffer for the unread tail of the previous one, also the longest VOP that can be decoded
+#define SIZEOF_FILE_READ_OVERLAP 262144ul
 #define FRAMES_IN_FLIGHT_COUNT 5 // number of frames that can be decoded ahead of display
+#define FAST_START_READ_SIZE 32768ul // fastStart: first read, the VOL and the first I-VOP
+#define FAST_START_RAMP_FRAMES 48 // fastStart: frames shown before the decode-ahead depth stops growing
+#define DIRECT_LCD_BUFFER_COUNT 2 // renderDirectToLCD: the buffer being scanned out and the one being decoded into
+#define MAX_DROPPED_FRAMES 8 // consecutive frames that may be dropped before playback resyncs to the clock
+#define SEEK_STEP_SECONDS 10 // left/right arrow
+// seeking without an index: the file is searched for I-VOPs in chunks, up to SEEK_SCAN_LIMIT bytes from the estimated position
+#define SEEK_SCAN_CHUNK_SIZE 32768ul
+#define SEEK_SCAN_LIMIT (32 * SEEK_SCAN_CHUNK_SIZE)
+#define SEEK_SCAN_DEFAULT_BYTES_PER_SECOND (500000 / 8) // until a second has been played, the README's ffmpeg bitrate
 #define FRAME_TOTAL_PIXELS (SCREEN_WIDTH * SCREEN_HEIGHT)
 #define CACHE_LINE_SIZE 32
 
 #define MAGIC_FRAMEBUFFER_ADDRESS ((uint8_t*)0xA8000000)
 
+// PL110/PL111 raw interrupt status and clear registers (same offsets on both),
+// LNBU is set once the controller has latched a new REAL_SCREEN_BASE_ADDRESS
+#define IO_LCD_RIS ((volatile uint32_t*)0xC0000020)
+#define IO_LCD_ICR ((volatile uint32_t*)0xC0000028)
+#define LCD_INT_LNBU (1 << 2)
+
 constexpr uint32_t timerHz = 12'000'000 / 256; // 12 MHz / 256 prescale
 constexpr uint32_t timerStartValue = 0xFFFFFFFF;
 
@@ -38,6 +58,7 @@ enum class HandleInsufficientDataResult {
 template <typename Framebuffer>
 struct FrameInFlightData {
     uint64_t timingTicks;
+    uint32_t frameNumber; // display order, counts dropped frames and N-VOPs too
     Framebuffer* swapchainFramePtr;
 };
 
@@ -47,9 +68,21 @@ struct VideoPlayerOptions {
     bool blitDuringBenchmark = false;
     bool useMagicFrameBuffer = true;
     bool preRotatedVideo = false; // incompatible with magic framebuffer
-
-    // TODO: skip the swapchain and render directly to LCD
-    // bool renderDirectToLCD = false;
+    // 320x240 video: the color conversion writes the LCD's portrait layout, so frames are shown
+    // like pre-rotated video instead of being copied into the magic framebuffer
+    bool rotateOnConversion = false;
+
+    // decode straight into the buffer that is scanned out next and flip the LCD base address,
+    // only two frame buffers and no blit. pre-rotated video or rotateOnConversion only, ignored otherwise
+    bool renderDirectToLCD = false;
+
+    bool frameDropping = true; // skip frames that can't be shown in time, never in benchmark mode
+    // show the first frame as soon as it is decoded, the rest of the frames in flight are
+    // decoded while playback waits for the next frame instead of before it starts
+    bool fastStart = true;
+    // color convert each macroblock row right after it is decoded (XVID_CSP_SLICE) while it is still cached,
+    // the decoder falls back to converting the whole picture where it can't (B-frame streams' reference frames)
+    bool sliceOutput = true;
 
     bool fastDecoding = true;
     // Low-delay disables B-frames; keep it off by default so B-VOPs can be decoded.
@@ -68,14 +101,29 @@ class VideoPlayer {
 
     FILE* videoFile = nullptr;
     bool fileEndReached = false;
+    bool decoderFlushed = false; // the last reference frame was taken out of the decoder at the end of the file
     void* xvidDecoderHandle = nullptr;
 
-    size_t decoderReadHead = SIZEOF_FILE_READ_BUFFER;
+    // Read-ahead ring. The decoder reads from readBuffers[decoderBufferIndex],
+    // fillReadBuffer() appends to readBuffers[fillBufferIndex] and moves on to the
+    // following buffers until it would overwrite the one being decoded.
+    // Each buffer is [overlap][file data][padding], when the decoder runs off the end
+    // of a buffer only its unread tail is copied into the overlap of the next one.
+    struct ReadBuffer {
+        uint8_t* base = nullptr; // start of the overlap area, file data starts at base + SIZEOF_FILE_READ_OVERLAP
+        size_t filled = 0;       // bytes of file data
+    };
+    std::unique_ptr<uint8_t[], ntls::mem::AlignedDeleter> fileReadBuffer; // backing storage of readBuffers
+    std::array<ReadBuffer, FILE_READ_BUFFER_COUNT> readBuffers{};
+    size_t decoderBufferIndex = 0;
+    size_t fillBufferIndex = 0;
+
+    size_t decoderReadHead = SIZEOF_FILE_READ_OVERLAP; // offset from readBuffers[decoderBufferIndex].base
     size_t decoderReadAvailable = 0;
-    std::unique_ptr<uint8_t[], ntls::mem::AlignedDeleter> fileReadBuffer;
 
-    std::unique_ptr<std::array<FrameBufferType, FRAMES_IN_FLIGHT_COUNT>, ntls::mem::AlignedDeleter> frameBuffersArray;
+    std::unique_ptr<FrameBufferType[], ntls::mem::AlignedDeleter> frameBuffersArray; // FRAMES_IN_FLIGHT_COUNT or DIRECT_LCD_BUFFER_COUNT buffers
     SwapChain<FrameBufferType, FRAMES_IN_FLIGHT_COUNT> decodedFramesSwapchain;
+    FrameBufferType* scanoutFrame = nullptr; // renderDirectToLCD: held until the LCD has switched to the next frame
 
     RingBuffer<FrameInFlightData<FrameBufferType>, FRAMES_IN_FLIGHT_COUNT> framesInFlightQueue;
 
@@ -94,37 +142,88 @@ class VideoPlayer {
     videoTimingInfo{};
 
     uint32_t lastFrameBlitTime = 0;
+    uint32_t lastFrameDecodeTime = 0; // of the last frame queued for display
+
+    // frames fillFramesInFlightQueue() keeps decoded ahead. fastStart starts at one and, while
+    // rampingUp, adds one whenever WaitForNextFrame() has the time to decode it instead of sleeping
+    size_t framesInFlightTarget = FRAMES_IN_FLIGHT_COUNT;
+    bool rampingUp = false;
+    uint32_t rampUpFramesLeft = 0;
+    uint32_t startupTicks = 0; // timer value when the constructor started
+
+    uint32_t playbackStartTicks = 0;
+    bool playbackStarted = false;
+
+    // frame dropping
+    uint32_t decodedFrameCounter = 0; // pictures the decoder returned so far, in display order
+    uint32_t droppedFrameStreak = 0;
+    uint32_t TargetTimerTicks(uint32_t timingTicks) const;
+    bool ShouldDropNextFrame();
+
+    // seeking with the arrow keys, through the I-VOPs listed in the sidecar index,
+    // without one by scanning the file for I-VOPs near a position estimated from the bitrate
+    std::vector<SeekIndexEntry> seekIndex; // empty without a usable index
+    uint64_t streamPositionTicks = 0; // stream time of the frame on screen, in the index's time base (estimated after a scan)
+    int64_t streamTimeOffset = 0; // stream time - frame timingTicks, the decoder's time stamps don't follow a jump
+    uint32_t seekTargetTicks = 0; // stream time of the I-VOP playback continues from
+    bool seekDiscontinuity = false; // the next decode call starts at a different place in the stream
+    bool seekKeyHeld = false;
+    void loadSeekIndex();
+    uint32_t decoderFileOffset() const;
+    // file offset of the I-VOP nearest to fromOffset in the given direction, within SEEK_SCAN_LIMIT bytes
+    std::optional<uint32_t> ScanForIVOP(uint32_t fromOffset, bool forward);
+    void SeekToByteOffset(uint32_t byteOffset, uint32_t streamTicks, uint32_t seekStartTicks);
 
-    uint32_t lastMemmoveTime = 0;
-    uint32_t lastMemmoveBytes = 0;
     uint32_t lastFileReadTime = 0;
     uint32_t lastFileReadBytes = 0;
 
     uint32_t CalculateFileReadAmount(uint32_t ticks);
 
+    // fixed size histograms, memory use doesn't depend on the length of the video
     struct {
-        std::vector<uint32_t> IFrame_DecodeTimes;
-        std::vector<uint32_t> PFrame_DecodeTimes;
-        std::vector<uint32_t> BFrame_DecodeTimes;
-        std::vector<uint32_t> SFrame_DecodeTimes;
-
-        std::vector<uint32_t> WastedFrame_DecodeTimes;
-
-        std::vector<uint32_t> Frame_BlitTimes;
-
-        // memmove time, bytes moved, fread time, bytes read
-        std::vector<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> Buffer_RefillTimes;
-
-        std::vector<int32_t> Pacing_WaitTimes;
-        std::vector<uint32_t> Frame_TotalTimes;
+        stats::Histogram<uint32_t> IFrame_DecodeTimes;
+        stats::Histogram<uint32_t> PFrame_DecodeTimes;
+        stats::Histogram<uint32_t> BFrame_DecodeTimes;
+        stats::Histogram<uint32_t> SFrame_DecodeTimes;
+
+        stats::Histogram<uint32_t> WastedFrame_DecodeTimes;
+        // decoded without being shown to catch up (no color conversion, B-VOPs parsed only)
+        stats::Histogram<uint32_t> DroppedFrame_DecodeTimes;
+        // N-VOPs and P-VOPs without a coded macroblock, not converted, the previous picture stays on screen
+        stats::Histogram<uint32_t> RepeatedFrame_DecodeTimes;
+        uint32_t Pacing_ResyncCount = 0;
+        // from the constructor until the first frame is on screen
+        uint32_t Startup_FirstFrameTime = 0;
+
+        stats::Histogram<uint32_t> Frame_BlitTimes;
+        // renderDirectToLCD: waiting for the LCD to latch the new base address
+        stats::Histogram<uint32_t> Frame_FlipWaitTimes;
+
+        // bytes read / fread time
+        stats::Histogram<uint32_t> Buffer_ReadRates;
+        // bytes copied into the overlap of the next read buffer
+        stats::Histogram<uint32_t> Buffer_OverlapCopySizes;
+        // reads the decoder had to wait for because read-ahead fell behind
+        stats::Histogram<uint32_t> Buffer_BlockingRefillTimes;
+
+        // from the key press until the queue is filled again
+        stats::Histogram<uint32_t> Seek_Times;
+
+        stats::Histogram<int32_t> Pacing_WaitTimes;
+        stats::Histogram<uint32_t> Frame_TotalTimes;
     } profilingInfo;
 
     bool failedFlag = false;
     std::string errorMsg = "Incomplete initialization";
 
     // return false if file end reached
-    bool fillReadBuffer(uint32_t requestedBytes = SIZEOF_FILE_READ_BUFFER);
-    void readVOLHeader();
+    bool fillReadBuffer(uint32_t requestedBytes = FILE_READ_BUFFER_COUNT * SIZEOF_FILE_READ_BUFFER);
+    size_t readAheadSpace() const;
+    // return false if no more data could be made available
+    bool advanceReadBuffer(const char* errorContext);
+    uint8_t* decoderReadPointer() const;
+    // discontinuity: first header of the stream, a later VOL must not throw away the pending reference frame
+    void readVOLHeader(bool discontinuity = true);
     HandleInsufficientDataResult handleInsufficientData(
         uint32_t frameDecodeStartTicks,
         FrameBufferType* frameBuffer,
@@ -137,8 +236,11 @@ class VideoPlayer {
 
     // play loop helpers
     void* InitLCD(); // returns old framebuffer pointer
-    void WaitForNextFrame(uint32_t timingTicks, uint32_t playbackStartTicks);
+    void WaitForNextFrame(uint32_t timingTicks);
     void DisplayFrame(FrameInFlightData<FrameBufferType>& frameData);
+    void WaitForScanoutFlip();
+    void HandleSeekKeys(); // may restart decoding somewhere else in the file
+    void ResyncClock(uint64_t timingTicks); // the frame with these timingTicks is due now
     void CleanupLCD(void* oldFramebufferPtr);
 
 public:
@@ -152,6 +254,6 @@ public:
 
     std::string dumpState() const;
 
-    std::string short_stats(const std::vector<std::uint32_t>& data) const;
-    std::string short_stats(const std::vector<std::int32_t>& data) const;
+    std::string short_stats(const stats::Histogram<std::uint32_t>& data) const;
+    std::string short_stats(const stats::Histogram<std::int32_t>& data) const;
 };
\ No newline at end of file
@@ -16,7 +16,7 @@ HandleInsufficientDataResult VideoPlayer::handleInsufficientData(
     const char* errorContext,
     bool requireDiscontinuity
 ) {
-    profilingInfo.WastedFrame_DecodeTimes.push_back(
+    profilingInfo.WastedFrame_DecodeTimes.add(
         frameDecodeStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1)
     );
 
@@ -24,19 +24,11 @@ HandleInsufficientDataResult VideoPlayer::handleInsufficientData(
     // (Callers only keep ownership when a decoded frame is pushed.)
     this->decodedFramesSwapchain.release(frameBuffer);
     
-    if (this->decoderReadAvailable == SIZEOF_FILE_READ_BUFFER) {
-        // buffer full but no progress, error
-        this->failedFlag = true;
-        this->errorMsg = std::string("Decoder stalled: ") + errorContext;
-        return HandleInsufficientDataResult::Error;
-    }
-    
-    if (!this->fileEndReached) {
-        // fillReadBuffer() returns true when more data may still be available.
-        this->fileEndReached = !this->fillReadBuffer();
-    }
-
-    if (this->fileEndReached) {
+    // advanceReadBuffer() returns true when more data was made available.
+    if (!this->advanceReadBuffer(errorContext)) {
+        if (this->failedFlag) {
+            return HandleInsufficientDataResult::Error;
+        }
         if (this->decoderReadAvailable == 0) {
             return HandleInsufficientDataResult::EndOfFile;
         }
@@ -62,9 +54,11 @@ void VideoPlayer::advanceReadHead(int bytesConsumed) {
 }
 
 void VideoPlayer::fillFramesInFlightQueue() {
-    bool hadDiscontinuity = false;
+    // after a seek the first call starts somewhere else in the stream
+    bool hadDiscontinuity = std::exchange(this->seekDiscontinuity, false);
 
-    while (!this->framesInFlightQueue.full() && this->decodedFramesSwapchain.availableCount() > 0) {
+    while (!this->framesInFlightQueue.full() && this->decodedFramesSwapchain.availableCount() > 0 &&
+           this->framesInFlightQueue.size() < this->framesInFlightTarget) {
         uint32_t frameDecodeStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
 
         xvid_dec_frame_t decFrame{};
@@ -76,14 +70,33 @@ void VideoPlayer::fillFramesInFlightQueue() {
             (this->options.deblockLuma ? XVID_DEBLOCKY : 0) |
             (this->options.deblockChroma ? XVID_DEBLOCKUV : 0) |
             (this->options.deringLuma ? XVID_DERINGY : 0) |
-            (this->options.deringChroma ? XVID_DERINGUV : 0)
+            (this->options.deringChroma ? XVID_DERINGUV : 0) |
+            XVID_DEC_REPEAT // pictures that repeat the previous one aren't color converted again
             ;
 
+        // catching up, the picture is decoded to keep the references intact but never shown
+        const bool skipOutput = this->ShouldDropNextFrame();
+        if (skipOutput) {
+            decFrame.general |= XVID_DEC_PREROLL | XVID_DEC_DROP;
+        }
+
         decFrame.general |= (hadDiscontinuity ? XVID_DISCONTINUITY : 0);
-        decFrame.bitstream = (void*)(this->fileReadBuffer.get() + this->decoderReadHead);
+        decFrame.bitstream = (void*)this->decoderReadPointer();
         decFrame.length = this->decoderReadAvailable;
+
+        // with B-VOPs the decoder holds back the last reference frame until it is flushed
+        const bool flushDecoder = this->fileEndReached && this->decoderReadAvailable == 0;
+        if (flushDecoder) {
+            if (this->decoderFlushed) {
+                return;
+            }
+            decFrame.bitstream = nullptr;
+            decFrame.length = -1;
+        }
         
-        decFrame.output.csp = XVID_CSP_RGB565;
+        decFrame.output.csp = XVID_CSP_RGB565 |
+            (this->options.rotateOnConversion ? XVID_CSP_ROTATE : 0) |
+            (this->options.sliceOutput ? XVID_CSP_SLICE : 0);
         if(this->options.benchmarkMode && !this->options.blitDuringBenchmark) {
             // in benchmark mode without blitting, skip color conversion to measure true decode speed
             decFrame.output.csp = XVID_CSP_INTERNAL;
@@ -97,7 +110,7 @@ void VideoPlayer::fillFramesInFlightQueue() {
             return;
         }
         decFrame.output.plane[0] = frameBuffer->data();
-        decFrame.output.stride[0] = (this->options.preRotatedVideo ? SCREEN_HEIGHT : SCREEN_WIDTH) * SIZEOF_RGB565;
+        decFrame.output.stride[0] = (this->options.useMagicFrameBuffer ? SCREEN_WIDTH : SCREEN_HEIGHT) * SIZEOF_RGB565;
 
         xvid_dec_stats_t decStats{};
         decStats.version = XVID_VERSION;
@@ -108,13 +121,20 @@ void VideoPlayer::fillFramesInFlightQueue() {
             &decFrame,
             &decStats
         );
-        if (bytesConsumed < 0) {
+        if (flushDecoder) {
+            this->decoderFlushed = true;
+            if (bytesConsumed < 0 || decStats.type <= 0) {
+                // nothing held back
+                this->decodedFramesSwapchain.release(frameBuffer);
+                return;
+            }
+            // queued below like any other frame, nothing was consumed
+        } else if (bytesConsumed < 0) {
             // error
             this->failedFlag = true;
             this->errorMsg = "Failed to decode frame: " + GetXvidErrorMessage(bytesConsumed);
             return;
-        } 
-        if (bytesConsumed == 0) {
+        } else if (bytesConsumed == 0) {
             // need more data
             auto result = handleInsufficientData(
                 frameDecodeStartTicks, frameBuffer, hadDiscontinuity,
@@ -146,15 +166,40 @@ void VideoPlayer::fillFramesInFlightQueue() {
                 continue;
             }
 
+            const uint32_t frameNumber = this->decodedFrameCounter++;
+            if (skipOutput) {
+                // dropped, nothing was written to the frame buffer
+                this->decodedFramesSwapchain.release(frameBuffer);
+                this->profilingInfo.DroppedFrame_DecodeTimes.add(
+                    frameDecodeStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1)
+                );
+                advanceReadHead(bytesConsumed);
+                hadDiscontinuity = false;
+                continue;
+            }
+            if (decStats.data.vop.general & XVID_VOP_REPEAT) {
+                // no coded macroblock, nothing was written to the frame buffer and
+                // the previous picture stays on screen for one more frame
+                this->decodedFramesSwapchain.release(frameBuffer);
+                this->profilingInfo.RepeatedFrame_DecodeTimes.add(
+                    frameDecodeStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1)
+                );
+                advanceReadHead(bytesConsumed);
+                hadDiscontinuity = false;
+                continue;
+            }
+
             // successful decode
             this->framesInFlightQueue.push(FrameInFlightData<FrameBufferType>{
                 .timingTicks = 
                 (uint64_t)decStats.data.vop.time_base * this->videoTimingInfo.timeIncrementResolution +
                 (uint64_t)decStats.data.vop.time_increment,
+                .frameNumber = frameNumber,
                 .swapchainFramePtr = frameBuffer
             });
 
-            [=]() -> std::vector<uint32_t>& {
+            this->lastFrameDecodeTime = frameDecodeStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+            [=]() -> stats::Histogram<uint32_t>& {
                 switch (decStats.type)
                 {
                 case XVID_TYPE_IVOP: return this->profilingInfo.IFrame_DecodeTimes;
@@ -164,9 +209,7 @@ void VideoPlayer::fillFramesInFlightQueue() {
                 default:
                     throw 1; // unreachable
                 }
-            }().push_back(
-                frameDecodeStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1)
-            );
+            }().add(this->lastFrameDecodeTime);
 
             // advance read head
             advanceReadHead(bytesConsumed);
@@ -175,7 +218,7 @@ void VideoPlayer::fillFramesInFlightQueue() {
         }
         if (decStats.type == XVID_TYPE_VOL) {
             // update video timing info
-            this->readVOLHeader();
+            this->readVOLHeader(/*discontinuity=*/false);
             if(this->failedFlag) {
                 return;
             }
@@ -199,14 +242,40 @@ void VideoPlayer::fillFramesInFlightQueue() {
                 }
                 continue;
             }
-            // ignore nvop frames
+            // ignore nvop frames, the previous picture stays on screen for one more frame
             this->decodedFramesSwapchain.release(frameBuffer);
+            this->decodedFrameCounter++;
+            this->profilingInfo.RepeatedFrame_DecodeTimes.add(
+                frameDecodeStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1)
+            );
             
             // advance read head
             advanceReadHead(bytesConsumed);
             hadDiscontinuity = false;
             continue;
         }
+        if (decStats.type == XVID_TYPE_NOTHING) {
+            // first reference frame of a stream with B-VOPs, it is output once the next one arrives
+            if ((size_t)bytesConsumed > this->decoderReadAvailable) {
+                auto result = handleInsufficientData(
+                    frameDecodeStartTicks, frameBuffer, hadDiscontinuity,
+                    "read beyond available data with full input buffer, the file read buffer may be too small.",
+                    /*requireDiscontinuity=*/false
+                );
+                if (result == HandleInsufficientDataResult::Error ||
+                    result == HandleInsufficientDataResult::EndOfFile) {
+                    return;
+                }
+                continue;
+            }
+            this->profilingInfo.WastedFrame_DecodeTimes.add(
+                frameDecodeStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1)
+            );
+            this->decodedFramesSwapchain.release(frameBuffer);
+            advanceReadHead(bytesConsumed);
+            hadDiscontinuity = false;
+            continue;
+        }
         // unexpected data type
         this->failedFlag = true;
         this->errorMsg = "Expected video frame, got different data type: " + std::to_string(decStats.type);
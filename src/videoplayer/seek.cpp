@@ -0,0 +1,201 @@
+#include "VideoPlayer.hpp"
+
+#include <xvid.h>
+
+#include <algorithm>
+
+#include <nspireio/uart.hpp>
+
+using namespace ntls::devices;
+
+void VideoPlayer::loadSeekIndex() {
+    // optional, without an index the arrow keys do nothing
+    const std::string indexPath = SeekIndexPathFor(this->options.filename);
+    FILE* indexFile = fopen(indexPath.c_str(), "rb");
+    if (!indexFile) {
+        return;
+    }
+
+    SeekIndexHeader header{};
+    std::vector<SeekIndexEntry> entries;
+    long indexFileSize = -1;
+    if (fseek(indexFile, 0, SEEK_END) == 0) {
+        indexFileSize = ftell(indexFile);
+        rewind(indexFile);
+    }
+    bool valid = fread(&header, sizeof(header), 1, indexFile) == 1 &&
+        header.magic == SEEK_INDEX_MAGIC && header.version == SEEK_INDEX_VERSION &&
+        header.timeIncrementResolution == this->videoTimingInfo.timeIncrementResolution &&
+        indexFileSize == (long)(sizeof(SeekIndexHeader) + (size_t)header.entryCount * sizeof(SeekIndexEntry));
+    if (valid) {
+        entries.resize(header.entryCount);
+        valid = entries.empty() ||
+            fread(entries.data(), sizeof(SeekIndexEntry), entries.size(), indexFile) == entries.size();
+    }
+    fclose(indexFile);
+
+    // offsets and times only go up, otherwise it was built for a different file
+    for (size_t i = 1; valid && i < entries.size(); i++) {
+        valid = entries[i].byteOffset > entries[i - 1].byteOffset && entries[i].timingTicks >= entries[i - 1].timingTicks;
+    }
+    if (!valid) {
+        uart_puts(("Ignoring unusable seek index " + indexPath + "\n").c_str());
+        return;
+    }
+    this->seekIndex = std::move(entries);
+}
+
+void VideoPlayer::HandleSeekKeys() {
+    const bool left = isKeyPressed(KEY_NSPIRE_LEFT);
+    const bool right = isKeyPressed(KEY_NSPIRE_RIGHT);
+    if (!left && !right) {
+        this->seekKeyHeld = false;
+        return;
+    }
+    // one jump per key press
+    if (this->seekKeyHeld) {
+        return;
+    }
+    this->seekKeyHeld = true;
+    const uint32_t seekStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+
+    const uint32_t timeIncrementResolution = this->videoTimingInfo.timeIncrementResolution;
+    const uint64_t position = this->streamPositionTicks;
+
+    if (this->seekIndex.empty()) {
+        // no index, guess the offset from the bitrate so far and look for the nearest I-VOP there
+        const uint32_t offset = this->decoderFileOffset();
+        const uint64_t bytesPerSecond = position >= timeIncrementResolution ?
+            std::max<uint64_t>((uint64_t)offset * timeIncrementResolution / position, 1) :
+            SEEK_SCAN_DEFAULT_BYTES_PER_SECOND;
+        const uint64_t step = SEEK_STEP_SECONDS * bytesPerSecond;
+        const uint32_t target = right ?
+            (uint32_t)std::min<uint64_t>((uint64_t)offset + step, UINT32_MAX) :
+            (offset > step ? offset - (uint32_t)step : 0);
+
+        const std::optional<uint32_t> found = this->ScanForIVOP(target, right);
+        if (!found) {
+            return;
+        }
+        this->SeekToByteOffset(*found, (uint32_t)((uint64_t)*found * timeIncrementResolution / bytesPerSecond), seekStartTicks);
+        return;
+    }
+
+    const uint64_t step = (uint64_t)SEEK_STEP_SECONDS * timeIncrementResolution;
+    const uint64_t target = right ? position + step : (position > step ? position - step : 0);
+
+    // the last I-VOP at or before the target
+    const auto byTime = [](uint64_t ticks, const SeekIndexEntry& entry) { return ticks < entry.timingTicks; };
+    auto entry = std::upper_bound(this->seekIndex.begin(), this->seekIndex.end(), target, byTime);
+    if (entry != this->seekIndex.begin()) {
+        --entry;
+    }
+    if (right && entry->timingTicks <= position) {
+        // no I-VOP within the step, take the next one
+        entry = std::upper_bound(this->seekIndex.begin(), this->seekIndex.end(), position, byTime);
+        if (entry == this->seekIndex.end()) {
+            return;
+        }
+    }
+    this->SeekToByteOffset(entry->byteOffset, entry->timingTicks, seekStartTicks);
+}
+
+uint32_t VideoPlayer::decoderFileOffset() const {
+    // the file position minus everything that was read ahead of the decoder
+    size_t bufferedBytes = this->decoderReadAvailable;
+    for (size_t i = this->decoderBufferIndex; i != this->fillBufferIndex;) {
+        i = (i + 1) % FILE_READ_BUFFER_COUNT;
+        bufferedBytes += this->readBuffers[i].filled;
+    }
+    return (uint32_t)(ftell(this->videoFile) - bufferedBytes);
+}
+
+std::optional<uint32_t> VideoPlayer::ScanForIVOP(uint32_t fromOffset, bool forward) {
+    // separate buffer, the read buffers keep what the decoder needs in case nothing is found
+    std::unique_ptr<uint8_t[], ntls::mem::AlignedDeleter> chunk(
+        static_cast<uint8_t*>(ntls::mem::AlignedAllocate(CACHE_LINE_SIZE, SEEK_SCAN_CHUNK_SIZE))
+    );
+    if (!chunk) {
+        return std::nullopt;
+    }
+    const long resumeOffset = ftell(this->videoFile);
+
+    std::optional<uint32_t> found;
+    uint32_t scanned = 0;
+    // forward: chunks start at chunkOffset. backward: chunks end at chunkEnd, 4 bytes past the
+    // last position that may still hold a start code
+    uint32_t chunkOffset = fromOffset;
+    uint32_t chunkEnd = (uint32_t)std::min<uint64_t>((uint64_t)fromOffset + 5, UINT32_MAX);
+    while (!found && scanned < SEEK_SCAN_LIMIT) {
+        if (!forward) {
+            chunkOffset = chunkEnd > SEEK_SCAN_CHUNK_SIZE ? chunkEnd - SEEK_SCAN_CHUNK_SIZE : 0;
+        }
+        const size_t bytesToRead = forward ? SEEK_SCAN_CHUNK_SIZE : chunkEnd - chunkOffset;
+        if (fseek(this->videoFile, chunkOffset, SEEK_SET) != 0) {
+            break;
+        }
+        const size_t bytesRead = fread(chunk.get(), 1, bytesToRead, this->videoFile);
+        const uint8_t* start = forward ?
+            findNextIVOPStartCode(chunk.get(), chunk.get() + bytesRead) :
+            findPrevIVOPStartCode(chunk.get(), chunk.get() + bytesRead);
+        if (start) {
+            found = chunkOffset + (uint32_t)(start - chunk.get());
+        } else if (forward) {
+            if (bytesRead < bytesToRead) {
+                break; // end of file
+            }
+            chunkOffset += SEEK_SCAN_CHUNK_SIZE - 4;
+        } else {
+            if (chunkOffset == 0) {
+                break; // start of file
+            }
+            chunkEnd = chunkOffset + 4;
+        }
+        scanned += bytesToRead;
+    }
+
+    if (!found) {
+        fseek(this->videoFile, resumeOffset, SEEK_SET);
+    }
+    return found;
+}
+
+void VideoPlayer::SeekToByteOffset(uint32_t byteOffset, uint32_t streamTicks, uint32_t seekStartTicks) {
+    // nothing that was decoded ahead is shown anymore
+    while (!this->framesInFlightQueue.empty()) {
+        bool success;
+        FrameInFlightData<FrameBufferType>& frameData = this->framesInFlightQueue.pop(success);
+        this->decodedFramesSwapchain.release(frameData.swapchainFramePtr);
+    }
+
+    // read on from the I-VOP, the decoder keeps the VOL it already has
+    if (fseek(this->videoFile, byteOffset, SEEK_SET) != 0) {
+        this->failedFlag = true;
+        this->errorMsg = "Failed to seek to offset " + std::to_string(byteOffset);
+        return;
+    }
+    for (ReadBuffer& readBuffer : this->readBuffers) {
+        readBuffer.filled = 0;
+    }
+    this->decoderBufferIndex = 0;
+    this->fillBufferIndex = 0;
+    this->decoderReadHead = SIZEOF_FILE_READ_OVERLAP;
+    this->decoderReadAvailable = 0;
+    // one buffer is enough to start, read-ahead fills the rest while playing
+    this->fileEndReached = !this->fillReadBuffer(SIZEOF_FILE_READ_BUFFER);
+    this->decoderFlushed = false;
+
+    // the reference frames are from before the jump, B-VOPs that still point at them are skipped by the decoder
+    this->seekDiscontinuity = true;
+    if (this->videoTimingInfo.fixedVopRate) {
+        this->decodedFrameCounter = (streamTicks + this->videoTimingInfo.fixedVopTimeIncrement / 2) /
+            this->videoTimingInfo.fixedVopTimeIncrement;
+    }
+    this->droppedFrameStreak = 0;
+    this->seekTargetTicks = streamTicks;
+    // nothing is late until the first frame from here is shown and sets the clock, see ResyncClock()
+    this->playbackStarted = false;
+
+    this->fillFramesInFlightQueue();
+    this->profilingInfo.Seek_Times.add(seekStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1));
+}
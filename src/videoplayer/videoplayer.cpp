@@ -8,6 +8,7 @@
 
 #include <new>
 #include <algorithm>
+#include <utility>
 
 #include <cstdio>
 
@@ -117,6 +118,7 @@ VideoPlayer::VideoPlayer(const VideoPlayerOptions& options) : options(options) {
     frameTimer.setControl(SP804SelectedTimer::Timer1, 
         frameTimer.getControl(SP804SelectedTimer::Timer1) | TIMER_CTRL_ENABLE
     );
+    this->startupTicks = frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
 
     // init lcd, decoder, file
     // open file
@@ -148,54 +150,43 @@ VideoPlayer::VideoPlayer(const VideoPlayerOptions& options) : options(options) {
     this->xvidDecoderHandle = xvid_dec_create.handle;
 
     // init buffers
+    constexpr size_t readBufferStride = SIZEOF_FILE_READ_OVERLAP + SIZEOF_FILE_READ_BUFFER + FILE_READ_BUFFER_PADDING;
     this->fileReadBuffer = std::unique_ptr<uint8_t[], ntls::mem::AlignedDeleter>(
-        static_cast<uint8_t*>(ntls::mem::AlignedAllocate(CACHE_LINE_SIZE, SIZEOF_FILE_READ_BUFFER + FILE_READ_BUFFER_PADDING))
+        static_cast<uint8_t*>(ntls::mem::AlignedAllocate(CACHE_LINE_SIZE, readBufferStride * FILE_READ_BUFFER_COUNT))
     );
     if (!this->fileReadBuffer) {
         this->failedFlag = true;
         this->errorMsg = "Failed to allocate file read buffer";
         return;
     }
-    // zero padding
-    memset(this->fileReadBuffer.get() + SIZEOF_FILE_READ_BUFFER, 0, FILE_READ_BUFFER_PADDING);
-
-    // allocate decoded frames buffer
-    this->frameBuffersArray = std::unique_ptr<std::array<FrameBufferType, FRAMES_IN_FLIGHT_COUNT>, ntls::mem::AlignedDeleter>(
-        reinterpret_cast<std::array<FrameBufferType, FRAMES_IN_FLIGHT_COUNT>*>(
-            ntls::mem::AlignedAllocate(CACHE_LINE_SIZE, sizeof(std::array<FrameBufferType, FRAMES_IN_FLIGHT_COUNT>))
-        )
-    );
-    if(!this->frameBuffersArray) {
-        this->failedFlag = true;
-        this->errorMsg = "Failed to allocate frame buffers array";
-        return;
+    for (size_t i = 0; i < FILE_READ_BUFFER_COUNT; i++) {
+        this->readBuffers[i].base = this->fileReadBuffer.get() + i * readBufferStride;
+        // zero padding
+        memset(this->readBuffers[i].base + SIZEOF_FILE_READ_OVERLAP + SIZEOF_FILE_READ_BUFFER, 0, FILE_READ_BUFFER_PADDING);
     }
-    new (this->frameBuffersArray.get()) std::array<FrameBufferType, FRAMES_IN_FLIGHT_COUNT>{};
 
-    // create refs to frame buffers for swapchain
-    std::array<FrameBufferType*, FRAMES_IN_FLIGHT_COUNT> frameBufferPtrs{};
-    for (size_t i = 0; i < FRAMES_IN_FLIGHT_COUNT; i++) {
-        frameBufferPtrs[i] = &(*this->frameBuffersArray)[i];
-    }
-    this->decodedFramesSwapchain.setBuffers(frameBufferPtrs);
-    
-    // prime read buffer
-    this->fillReadBuffer();
+    // prime read buffers, fastStart leaves the rest to read-ahead during playback. benchmarks start with full buffers
+    const bool fastStart = this->options.fastStart && !this->options.benchmarkMode;
+    this->fileEndReached = !this->fillReadBuffer(
+        fastStart ? FAST_START_READ_SIZE : FILE_READ_BUFFER_COUNT * SIZEOF_FILE_READ_BUFFER
+    );
 
     // try get vol header
     this->readVOLHeader();
     if(this->failedFlag) {
         return;
     }
+    this->loadSeekIndex();
 
     // check video dimensions
     // auto detect
     if(this->videoWidth == SCREEN_WIDTH && this->videoHeight == SCREEN_HEIGHT) {
         this->options.preRotatedVideo = false;
-        this->options.useMagicFrameBuffer = true;
+        this->options.useMagicFrameBuffer = !this->options.rotateOnConversion;
     } else if (this->videoWidth == SCREEN_HEIGHT && this->videoHeight == SCREEN_WIDTH) {
         this->options.preRotatedVideo = true;
         this->options.useMagicFrameBuffer = false;
+        this->options.rotateOnConversion = false;
     } else {
         this->failedFlag = true;
         this->errorMsg = 
@@ -207,8 +198,36 @@ VideoPlayer::VideoPlayer(const VideoPlayerOptions& options) : options(options) {
             std::to_string(SCREEN_HEIGHT) + "x" + std::to_string(SCREEN_WIDTH);
         return;
     }
+    if (this->options.useMagicFrameBuffer) {
+        // the magic framebuffer needs the blit
+        this->options.renderDirectToLCD = false;
+    }
 
-    // fill decoded frames buffer
+    // allocate decoded frames buffer
+    const size_t frameBufferCount = this->options.renderDirectToLCD ? DIRECT_LCD_BUFFER_COUNT : FRAMES_IN_FLIGHT_COUNT;
+    this->frameBuffersArray = std::unique_ptr<FrameBufferType[], ntls::mem::AlignedDeleter>(
+        static_cast<FrameBufferType*>(
+            ntls::mem::AlignedAllocate(CACHE_LINE_SIZE, sizeof(FrameBufferType) * frameBufferCount)
+        )
+    );
+    if(!this->frameBuffersArray) {
+        this->failedFlag = true;
+        this->errorMsg = "Failed to allocate frame buffers array";
+        return;
+    }
+    memset(this->frameBuffersArray.get(), 0, sizeof(FrameBufferType) * frameBufferCount);
+
+    // create refs to frame buffers for swapchain, unused slots stay null
+    std::array<FrameBufferType*, FRAMES_IN_FLIGHT_COUNT> frameBufferPtrs{};
+    for (size_t i = 0; i < frameBufferCount; i++) {
+        frameBufferPtrs[i] = &this->frameBuffersArray[i];
+    }
+    this->decodedFramesSwapchain.setBuffers(frameBufferPtrs);
+
+    // fill decoded frames buffer, fastStart stops after the first frame
+    this->rampingUp = fastStart;
+    this->rampUpFramesLeft = FAST_START_RAMP_FRAMES;
+    this->framesInFlightTarget = fastStart ? 1 : FRAMES_IN_FLIGHT_COUNT;
     this->fillFramesInFlightQueue();
     if (this->failedFlag) {
         return;
@@ -239,82 +258,139 @@ std::string VideoPlayer::getErrorMessage() const {
 bool VideoPlayer::fillReadBuffer(uint32_t requestedBytes) {
     // Returns true if more data may still be available (i.e., not at EOF).
     // Callers interpret false as end-of-file reached.
-    uint32_t memmoveStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
-
-    // Compact unread bytes to the start of the buffer.
-    if (this->decoderReadHead > 0 && this->decoderReadAvailable > 0) {
-        memmove(
-            (void*)this->fileReadBuffer.get(),
-            (void*)this->fileReadBuffer.get() + this->decoderReadHead,
-            this->decoderReadAvailable
-        );
-    }
-    // After compaction, unread data begins at index 0.
-    this->decoderReadHead = 0;
-
-    uint32_t memmoveEndTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+    // Only appends behind the data the decoder still needs, nothing is moved.
+    while (requestedBytes > 0) {
+        ReadBuffer& target = this->readBuffers[this->fillBufferIndex];
+        if (target.filled == SIZEOF_FILE_READ_BUFFER) {
+            const size_t nextIndex = (this->fillBufferIndex + 1) % FILE_READ_BUFFER_COUNT;
+            if (nextIndex == this->decoderBufferIndex) {
+                // every buffer is ahead of the decoder; not EOF.
+                return true;
+            }
+            this->fillBufferIndex = nextIndex;
+            this->readBuffers[nextIndex].filled = 0;
+            continue;
+        }
 
-    const uint32_t freeSpace = SIZEOF_FILE_READ_BUFFER - static_cast<uint32_t>(this->decoderReadAvailable);
-    const uint32_t bytesToRead = std::min<uint32_t>(requestedBytes, freeSpace);
+        const uint32_t bytesToRead = std::min<uint32_t>(requestedBytes, SIZEOF_FILE_READ_BUFFER - target.filled);
 
-    const uint32_t fileReadStartTicks = memmoveEndTicks;
-    uint32_t bytesRead = 0;
-    if (bytesToRead > 0) {
-        bytesRead = fread(
-            (void*)this->fileReadBuffer.get() + this->decoderReadAvailable,
+        const uint32_t fileReadStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+        const uint32_t bytesRead = fread(
+            target.base + SIZEOF_FILE_READ_OVERLAP + target.filled,
             1,
             bytesToRead,
             this->videoFile
         );
-        this->decoderReadAvailable += bytesRead;
+        const uint32_t fileReadEndTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+
+        target.filled += bytesRead;
+        if (this->fillBufferIndex == this->decoderBufferIndex) {
+            // reading into the buffer being decoded, the data is usable right away
+            this->decoderReadAvailable += bytesRead;
+        }
+        requestedBytes -= bytesRead;
+
+        this->lastFileReadTime = fileReadStartTicks - fileReadEndTicks;
+        this->lastFileReadBytes = bytesRead;
+        this->profilingInfo.Buffer_ReadRates.add(
+            this->lastFileReadBytes / (this->lastFileReadTime ? this->lastFileReadTime : 1)
+        );
+
+        // If we couldn't fill the requested amount, treat it as end-of-file.
+        // (Short reads can also happen for other reasons, but for this project
+        //  we treat them as EOF.)
+        if (bytesRead < bytesToRead) {
+            return false;
+        }
     }
-    const uint32_t fileReadEndTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
-
-    this->lastMemmoveTime = memmoveStartTicks - memmoveEndTicks;
-    this->lastMemmoveBytes = static_cast<uint32_t>(this->decoderReadAvailable) - bytesRead;
-    this->lastFileReadTime = fileReadStartTicks - fileReadEndTicks;
-    this->lastFileReadBytes = bytesRead;
-
-    this->profilingInfo.Buffer_RefillTimes.push_back({
-        this->lastMemmoveTime,
-        this->lastMemmoveBytes,
-        this->lastFileReadTime,
-        this->lastFileReadBytes
-    });
-
-    // If we couldn't fill the requested amount, treat it as end-of-file.
-    // (Short reads can also happen for other reasons, but for this project
-    //  we treat them as EOF.)
-    if (bytesToRead == 0) {
-        // Buffer full; not EOF.
-        return true;
+    return true;
+}
+
+size_t VideoPlayer::readAheadSpace() const {
+    // free space in the buffer being filled plus the empty buffers between it and the decoder
+    const size_t emptyBuffers = (this->decoderBufferIndex + FILE_READ_BUFFER_COUNT - this->fillBufferIndex - 1) % FILE_READ_BUFFER_COUNT;
+    return (SIZEOF_FILE_READ_BUFFER - this->readBuffers[this->fillBufferIndex].filled) + emptyBuffers * SIZEOF_FILE_READ_BUFFER;
+}
+
+uint8_t* VideoPlayer::decoderReadPointer() const {
+    return this->readBuffers[this->decoderBufferIndex].base + this->decoderReadHead;
+}
+
+bool VideoPlayer::advanceReadBuffer(const char* errorContext) {
+    const ReadBuffer& current = this->readBuffers[this->decoderBufferIndex];
+
+    if (this->fillBufferIndex == this->decoderBufferIndex && current.filled < SIZEOF_FILE_READ_BUFFER) {
+        // the decoder caught up with read-ahead, wait for the rest of this buffer
+        if (this->fileEndReached) {
+            return false;
+        }
+        const size_t availableBefore = this->decoderReadAvailable;
+        const uint32_t blockingStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+        this->fileEndReached = !this->fillReadBuffer(SIZEOF_FILE_READ_BUFFER - current.filled);
+        this->profilingInfo.Buffer_BlockingRefillTimes.add(
+            blockingStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1)
+        );
+        return this->decoderReadAvailable > availableBefore;
+    }
+
+    // this buffer is used up, continue in the next one
+    if (this->decoderReadAvailable > SIZEOF_FILE_READ_OVERLAP) {
+        // the decoder made no progress on more data than a frame may take
+        this->failedFlag = true;
+        this->errorMsg = std::string("Decoder stalled: ") + errorContext;
+        return false;
+    }
+
+    const size_t nextIndex = (this->decoderBufferIndex + 1) % FILE_READ_BUFFER_COUNT;
+    if (this->fillBufferIndex == this->decoderBufferIndex) {
+        // read-ahead stopped exactly at the end of this buffer
+        if (this->fileEndReached) {
+            return false;
+        }
+        this->fillBufferIndex = nextIndex;
+        this->readBuffers[nextIndex].filled = 0;
     }
-    return bytesRead == bytesToRead;
+    ReadBuffer& next = this->readBuffers[nextIndex];
+    if (next.filled == 0) {
+        if (this->fileEndReached) {
+            return false;
+        }
+        const uint32_t blockingStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+        this->fileEndReached = !this->fillReadBuffer(SIZEOF_FILE_READ_BUFFER);
+        this->profilingInfo.Buffer_BlockingRefillTimes.add(
+            blockingStartTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1)
+        );
+        if (next.filled == 0) {
+            return false;
+        }
+    }
+
+    // carry the unread tail over so it directly precedes the next buffer's data
+    const size_t tailBytes = this->decoderReadAvailable;
+    memcpy(next.base + SIZEOF_FILE_READ_OVERLAP - tailBytes, this->decoderReadPointer(), tailBytes);
+    this->profilingInfo.Buffer_OverlapCopySizes.add(static_cast<uint32_t>(tailBytes));
+
+    this->decoderBufferIndex = nextIndex;
+    this->decoderReadHead = SIZEOF_FILE_READ_OVERLAP - tailBytes;
+    this->decoderReadAvailable = tailBytes + next.filled;
+    return true;
 }
 
 uint32_t VideoPlayer::CalculateFileReadAmount(uint32_t ticks) {
     // calculate how much data can be read in given ticks
     // use last read speed as reference
-    const uint32_t memmoveBytesPerTick = (this->lastMemmoveBytes) / (this->lastMemmoveTime ? this->lastMemmoveTime : 1);
     const uint32_t fileReadBytesPerTick = (this->lastFileReadBytes) / (this->lastFileReadTime ? this->lastFileReadTime : 1);
-
-    // calculate the time needed for memmove
-    const uint32_t estimatedMemmoveTime = (this->decoderReadAvailable) / (memmoveBytesPerTick ? memmoveBytesPerTick : 1);
-    if(estimatedMemmoveTime >= ticks) {
-        return 0;
-    }
-    // remaining time for file read
-    const uint32_t remainingTicks = ticks - estimatedMemmoveTime;
-    return remainingTicks * fileReadBytesPerTick;
+    return ticks * fileReadBytesPerTick;
 }
 
 void VideoPlayer::play() {
     void* oldBuf = this->InitLCD();
 
-    uint32_t playbackStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+    this->playbackStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+    this->playbackStarted = true;
+    bool firstFrame = true;
 
     // play video
-    uint64_t frameCounter = 0;
     while (true) {
         uint32_t frameStartTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
         // escape
@@ -325,6 +401,10 @@ void VideoPlayer::play() {
                 break;
             }
         }
+        this->HandleSeekKeys();
+        if (this->failedFlag) {
+            break;
+        }
 
         // check frames in flight
         if (this->framesInFlightQueue.empty()) {
@@ -344,35 +424,65 @@ void VideoPlayer::play() {
             break;
         }
         // fixed VOP rate adjustment
-        frameData.timingTicks = (this->videoTimingInfo.fixedVopRate ? (frameCounter * this->videoTimingInfo.fixedVopTimeIncrement) : frameData.timingTicks);
+        frameData.timingTicks = (this->videoTimingInfo.fixedVopRate ? ((uint64_t)frameData.frameNumber * this->videoTimingInfo.fixedVopTimeIncrement) : frameData.timingTicks);
+
+        if (!this->playbackStarted) {
+            // first frame after a seek
+            this->ResyncClock(frameData.timingTicks);
+            this->streamTimeOffset = (int64_t)this->seekTargetTicks - (int64_t)frameData.timingTicks;
+        }
+        this->streamPositionTicks = frameData.timingTicks + this->streamTimeOffset;
 
-        this->WaitForNextFrame(frameData.timingTicks, playbackStartTicks);
+        this->WaitForNextFrame(frameData.timingTicks);
         
         // display frame
+        const bool displayFrame = !this->options.benchmarkMode || this->options.blitDuringBenchmark;
         uint32_t ticksBeforeBlit = frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
-        if (!this->options.benchmarkMode || this->options.blitDuringBenchmark) {
+        if (displayFrame) {
             this->DisplayFrame(frameData);
-            frameCounter++;
         }
         uint32_t ticksAfterBlit = frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
-        this->lastFrameBlitTime = ticksBeforeBlit - ticksAfterBlit;
-        profilingInfo.Frame_BlitTimes.push_back(this->lastFrameBlitTime);
-
-        // before releasing, fill more frames in flight
-        this->fillFramesInFlightQueue();
-        if (this->failedFlag) {
-            break;
+        if (firstFrame) {
+            this->profilingInfo.Startup_FirstFrameTime = this->startupTicks - ticksAfterBlit;
+            firstFrame = false;
         }
 
-        // release frame buffer back to swapchain
-        if (!this->decodedFramesSwapchain.release(frameData.swapchainFramePtr)) {
-            this->failedFlag = true;
-            this->errorMsg = "Failed to release frame buffer back to swapchain";
-            break;
+        if (this->options.renderDirectToLCD && displayFrame) {
+            // nothing to blit, the frame was decoded into the buffer the LCD now shows.
+            // the previous one can only be decoded into again once the LCD has let go of it
+            this->lastFrameBlitTime = 0;
+            this->WaitForScanoutFlip();
+            FrameBufferType* previousFrame = std::exchange(this->scanoutFrame, frameData.swapchainFramePtr);
+            if (previousFrame && previousFrame != frameData.swapchainFramePtr &&
+                !this->decodedFramesSwapchain.release(previousFrame)) {
+                this->failedFlag = true;
+                this->errorMsg = "Failed to release frame buffer back to swapchain";
+                break;
+            }
+            this->fillFramesInFlightQueue();
+            if (this->failedFlag) {
+                break;
+            }
+        } else {
+            this->lastFrameBlitTime = ticksBeforeBlit - ticksAfterBlit;
+            profilingInfo.Frame_BlitTimes.add(this->lastFrameBlitTime);
+
+            // before releasing, fill more frames in flight
+            this->fillFramesInFlightQueue();
+            if (this->failedFlag) {
+                break;
+            }
+
+            // release frame buffer back to swapchain
+            if (!this->decodedFramesSwapchain.release(frameData.swapchainFramePtr)) {
+                this->failedFlag = true;
+                this->errorMsg = "Failed to release frame buffer back to swapchain";
+                break;
+            }
         }
         
         uint32_t frameEndTicks = this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
-        profilingInfo.Frame_TotalTimes.push_back(frameStartTicks - frameEndTicks);
+        profilingInfo.Frame_TotalTimes.add(frameStartTicks - frameEndTicks);
         
     }
 
@@ -411,18 +521,55 @@ void VideoPlayer::CleanupLCD(void* oldFramebufferPtr) {
     pwr_lcd(true);
 }
 
-void VideoPlayer::WaitForNextFrame(uint32_t timingTicks, uint32_t playbackStartTicks) {
-    uint32_t targetTicksElapsed = ((timingTicks * timerHz) + (this->videoTimingInfo.timeIncrementResolution / 2)) / this->videoTimingInfo.timeIncrementResolution;
-    uint32_t targetTimerTicks = playbackStartTicks - targetTicksElapsed + this->lastFrameBlitTime;
+uint32_t VideoPlayer::TargetTimerTicks(uint32_t timingTicks) const {
+    // 64 bit, timingTicks * timerHz overflows after a few minutes of video
+    uint32_t targetTicksElapsed = (((uint64_t)timingTicks * timerHz) + (this->videoTimingInfo.timeIncrementResolution / 2)) / this->videoTimingInfo.timeIncrementResolution;
+    return this->playbackStartTicks - targetTicksElapsed + this->lastFrameBlitTime;
+}
+
+void VideoPlayer::ResyncClock(uint64_t timingTicks) {
+    // TargetTimerTicks() moves one to one with playbackStartTicks
+    this->playbackStartTicks += this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1) - this->TargetTimerTicks(timingTicks);
+    this->playbackStarted = true;
+}
+
+void VideoPlayer::WaitForNextFrame(uint32_t timingTicks) {
+    uint32_t targetTimerTicks = this->TargetTimerTicks(timingTicks);
     {
         constexpr uint32_t marginOfErrorTicks = timerHz / (1000); // 1 ms margin of error
-        constexpr uint32_t attemptReadThreshold = SIZEOF_FILE_READ_BUFFER / 2; // try read if less than 1/2 buffer free
         int32_t ticksToWait = frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1) - targetTimerTicks;
-        
-        // if there is extra time to do other processing, try to fill read buffer
-        if (!this->fileEndReached && ticksToWait > marginOfErrorTicks && this->decoderReadAvailable < attemptReadThreshold) {
+
+        // fastStart: decode one more frame ahead with time that would otherwise be slept.
+        // the frame taken off the queue for this wait is refilled now as well, instead of after the blit
+        if (this->rampingUp) {
+            const size_t framesToDecode = this->framesInFlightTarget + 1 - this->framesInFlightQueue.size();
+            if (this->framesInFlightTarget >= this->framesInFlightQueue.capacity() ||
+                this->decodedFramesSwapchain.availableCount() == 0) {
+                // every buffer is in use, from here on the queue is kept full
+                this->rampingUp = false;
+                this->framesInFlightTarget = FRAMES_IN_FLIGHT_COUNT;
+            } else if (ticksToWait > (int32_t)(framesToDecode * this->lastFrameDecodeTime + marginOfErrorTicks)) {
+                uint32_t decodeStartTime = frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+                this->framesInFlightTarget++;
+                this->fillFramesInFlightQueue();
+                if (this->failedFlag) {
+                    return;
+                }
+                ticksToWait -= (decodeStartTime - frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1));
+            }
+            if (this->rampingUp && --this->rampUpFramesLeft == 0) {
+                // decoding rarely leaves the time, keep the depth reached so far
+                this->rampingUp = false;
+            }
+        }
+
+        // if there is extra time to do other processing, read ahead into the free read buffers
+        if (!this->fileEndReached && ticksToWait > marginOfErrorTicks && this->readAheadSpace() > 0) {
             uint32_t readStartTime = frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
-            uint32_t fileReadAmount = this->CalculateFileReadAmount(ticksToWait - marginOfErrorTicks);
+            uint32_t fileReadAmount = std::min<uint32_t>(
+                this->CalculateFileReadAmount(ticksToWait - marginOfErrorTicks),
+                this->readAheadSpace()
+            );
             if(fileReadAmount > 0) {
                 this->fileEndReached = !this->fillReadBuffer(fileReadAmount);
                 if (this->failedFlag) {
@@ -433,7 +580,7 @@ void VideoPlayer::WaitForNextFrame(uint32_t timingTicks, uint32_t playbackStartT
             }
         }
 
-        profilingInfo.Pacing_WaitTimes.push_back(ticksToWait);
+        profilingInfo.Pacing_WaitTimes.add(ticksToWait);
         if (ticksToWait > 0) { 
             // calculate sleep time in ms
             uint32_t sleepMs = (ticksToWait * 1000) / timerHz;
@@ -441,12 +588,40 @@ void VideoPlayer::WaitForNextFrame(uint32_t timingTicks, uint32_t playbackStartT
                 msleep(sleepMs);
             }
         } else {
-            // TODO: implement frame skipping
-            // uart_puts((std::string("Frame late by ") + std::to_string(-ticksToWait) + " ticks\n").c_str());
+            // late, ShouldDropNextFrame() skips the frames that can't make it anymore
         }
     }
 }
 
+bool VideoPlayer::ShouldDropNextFrame() {
+    // only fixed VOP rate streams tell when a frame is due before it is decoded
+    if (!this->options.frameDropping || this->options.benchmarkMode || !this->playbackStarted ||
+        !this->videoTimingInfo.fixedVopRate) {
+        return false;
+    }
+
+    // the next picture out of the decoder is decodedFrameCounter in display order,
+    // it is not worth decoding for display if its slot has already passed by a whole frame
+    const uint32_t frameTicks = (this->videoTimingInfo.fixedVopTimeIncrement * timerHz) / this->videoTimingInfo.timeIncrementResolution;
+    const uint32_t targetTimerTicks = this->TargetTimerTicks(this->decodedFrameCounter * this->videoTimingInfo.fixedVopTimeIncrement);
+    const int32_t lateTicks = targetTimerTicks - this->frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+    if (lateTicks < (int32_t)frameTicks) {
+        this->droppedFrameStreak = 0;
+        return false;
+    }
+
+    if (this->droppedFrameStreak >= MAX_DROPPED_FRAMES) {
+        // can't catch up, show this one and continue at normal speed from here
+        // (the timer counts down, starting later means a smaller start value)
+        this->playbackStartTicks -= lateTicks;
+        this->droppedFrameStreak = 0;
+        this->profilingInfo.Pacing_ResyncCount++;
+        return false;
+    }
+    this->droppedFrameStreak++;
+    return true;
+}
+
 void VideoPlayer::DisplayFrame(FrameInFlightData<FrameBufferType>& frameData) {
     if(this->options.useMagicFrameBuffer) {
         // copy from frame buffer to mfb
@@ -457,16 +632,40 @@ void VideoPlayer::DisplayFrame(FrameInFlightData<FrameBufferType>& frameData) {
             chunks_32byte
         );
     } else {
-        // pre rotated, can display directly
+        // frame is already in portrait layout, can display directly
+        if (this->options.renderDirectToLCD) {
+            *IO_LCD_ICR = LCD_INT_LNBU;
+        }
         REAL_SCREEN_BASE_ADDRESS = frameData.swapchainFramePtr->data();
     }
 }
 
+void VideoPlayer::WaitForScanoutFlip() {
+    // the LCD keeps reading the old buffer until the next refresh starts, at most one refresh (~17 ms).
+    // give up after two in case the controller doesn't report it, tearing beats hanging
+    constexpr uint32_t flipTimeoutTicks = timerHz / 30;
+    constexpr uint32_t readAheadChunk = 4096;
+
+    const uint32_t waitStartTicks = frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+    uint32_t waitedTicks = 0;
+    while (!(*IO_LCD_RIS & LCD_INT_LNBU) && waitedTicks < flipTimeoutTicks) {
+        // use the time for read-ahead
+        if (!this->fileEndReached && this->readAheadSpace() > 0) {
+            this->fileEndReached = !this->fillReadBuffer(std::min<uint32_t>(readAheadChunk, this->readAheadSpace()));
+        }
+        waitedTicks = waitStartTicks - frameTimer.getCurrentValue32(SP804SelectedTimer::Timer1);
+    }
+    this->profilingInfo.Frame_FlipWaitTimes.add(waitedTicks);
+}
+
 std::string VideoPlayer::dumpState() const {
     std::string state;
     state += "VideoPlayer State Dump:\n";
     state += "-----------------------\n";
     state += "Video File: " + std::string(this->videoFile ? "Open" : "Closed") + "\n";
+    state += "Read Buffers (decode/fill): " + 
+        std::to_string(this->decoderBufferIndex) + "/" + std::to_string(this->fillBufferIndex) + 
+        " of " + std::to_string(FILE_READ_BUFFER_COUNT) + ", read-ahead space " + std::to_string(this->readAheadSpace()) + "\n";
     state += "Decoder Read Head: " + std::to_string(this->decoderReadHead) + "\n";
     state += "Decoder Read Available: " + std::to_string(this->decoderReadAvailable) + "\n";
     state += "Decoded Frames Swapchain Available Count: " + 
@@ -484,6 +683,23 @@ std::string VideoPlayer::dumpState() const {
         std::to_string(this->videoTimingInfo.fixedVopTimeIncrement) + "\n";
     state += "Last Frame Blit Time (ticks): " + 
         std::to_string(this->lastFrameBlitTime) + "\n";
+    {
+        xvid_gbl_sram_t sram{};
+        sram.version = XVID_VERSION;
+        if (xvid_global(nullptr, XVID_GBL_SRAM, &sram, nullptr) == 0) {
+            state += "SRAM (bytes): " + std::to_string(sram.used) + " used, " +
+                std::to_string(sram.peak) + " peak of " + std::to_string(sram.size) + ", " +
+                std::to_string(sram.spills) + " allocations (" + std::to_string(sram.spilled_bytes) +
+                " bytes) spilled to SDRAM\n";
+            std::string sdram;
+            for (int i = 0; i < sram.num_objects; ++i) {
+                if (sram.objects[i].bytes && !sram.objects[i].in_sram) {
+                    sdram += std::string(sdram.empty() ? "" : ", ") + sram.objects[i].name;
+                }
+            }
+            state += "Placed in SDRAM: " + (sdram.empty() ? std::string("none") : sdram) + "\n";
+        }
+    }
     state += "Failed Flag: " + std::string(this->failedFlag ? "True" : "False") + "\n";
     state += "Error Message: " + this->errorMsg + "\n";
 
@@ -494,47 +710,30 @@ std::string VideoPlayer::dumpState() const {
     state += "B dec: " + this->short_stats(this->profilingInfo.BFrame_DecodeTimes) + "\n";
     state += "S dec: " + this->short_stats(this->profilingInfo.SFrame_DecodeTimes) + "\n";
     state += "Wasted dec: " + this->short_stats(this->profilingInfo.WastedFrame_DecodeTimes) + "\n";
+    state += "Dropped dec: " + this->short_stats(this->profilingInfo.DroppedFrame_DecodeTimes) + "\n";
+    state += "Repeated dec: " + this->short_stats(this->profilingInfo.RepeatedFrame_DecodeTimes) + "\n";
     state += "Blit: " + this->short_stats(this->profilingInfo.Frame_BlitTimes) + "\n";
-    state += "Memmove times (bytes/tick): " + this->short_stats(
-        [this]{
-            std::vector<uint32_t> out;
-            out.reserve(profilingInfo.Buffer_RefillTimes.size() * 2);
-            for (const auto& [mmTime, bytesMoved, freadTime, bytesRead] : profilingInfo.Buffer_RefillTimes) {
-                out.push_back(bytesMoved / (mmTime ? mmTime : 1));
-            }
-            return out;
-        }()
-    ) + "\n";
-    state += "File Read Times (bytes/tick): " + this->short_stats(
-        [this]{
-            std::vector<uint32_t> out;
-            out.reserve(profilingInfo.Buffer_RefillTimes.size());
-            for (const auto& [mmTime, bytesMoved, freadTime, bytesRead] : profilingInfo.Buffer_RefillTimes) {
-                out.push_back(bytesRead / (freadTime ? freadTime : 1));
-            }
-            return out;
-        }()
-    ) + "\n";
+    state += "Flip wait: " + this->short_stats(this->profilingInfo.Frame_FlipWaitTimes) + "\n";
+    state += "Overlap copy sizes (bytes): " + this->short_stats(this->profilingInfo.Buffer_OverlapCopySizes) + "\n";
+    state += "File Read Times (bytes/tick): " + this->short_stats(this->profilingInfo.Buffer_ReadRates) + "\n";
+    state += "Blocking refills: " + this->short_stats(this->profilingInfo.Buffer_BlockingRefillTimes) + "\n";
     state += "Pacing Wait Times: " + this->short_stats(this->profilingInfo.Pacing_WaitTimes) + "\n";
-    state += "Frame too late count: " + std::to_string(
-        std::count_if(
-            this->profilingInfo.Pacing_WaitTimes.begin(),
-            this->profilingInfo.Pacing_WaitTimes.end(),
-            [](int32_t v) { return v < 0; }
-        )
-    ) + "\n";
+    state += "Frame too late count: " + std::to_string(this->profilingInfo.Pacing_WaitTimes.countNegative()) + "\n";
+    state += "Playback resyncs: " + std::to_string(this->profilingInfo.Pacing_ResyncCount) + "\n";
+    state += "Time to first frame (ticks): " + std::to_string(this->profilingInfo.Startup_FirstFrameTime) +
+        (this->rampingUp ? ", ramping up for up to " + std::to_string(this->rampUpFramesLeft) + " more frames" : "") + "\n";
+    state += "Frames decoded ahead: " + std::to_string(this->framesInFlightTarget) + " of " + std::to_string(FRAMES_IN_FLIGHT_COUNT) + "\n";
+    state += "Seek index entries: " + std::to_string(this->seekIndex.size()) + "\n";
+    state += "Seeks: " + this->short_stats(this->profilingInfo.Seek_Times) + "\n";
     state += "Total Frame Times: " + this->short_stats(this->profilingInfo.Frame_TotalTimes) + "\n";
     state += "Average FPS: " + std::to_string(
         [this]() -> float {
-            uint64_t totalTicks = 0;
-            for (const auto& t : this->profilingInfo.Frame_TotalTimes) {
-                totalTicks += t;
-            }
+            const uint64_t totalTicks = this->profilingInfo.Frame_TotalTimes.sum();
             if (totalTicks == 0) {
                 return 0.0;
             }
             float totalSeconds = static_cast<float>(totalTicks) / static_cast<float>(timerHz);
-            return static_cast<float>(this->profilingInfo.Frame_TotalTimes.size()) / totalSeconds;
+            return static_cast<float>(this->profilingInfo.Frame_TotalTimes.count()) / totalSeconds;
         }()
     ) + "\n";
     return state;
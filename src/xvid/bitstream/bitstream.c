@@ -33,6 +33,27 @@
 #include "mbcoding.h"
 
 
+/* End of the stream for BitstreamCheckTail(): up to XVID_BS_BOUNCE_MARGIN bytes
+ * of data, then zeros for one more macroblock. Only one VOP is decoded at a time. */
+static uint32_t bs_bounce[(2 * XVID_BS_BOUNCE_MARGIN + 16) / sizeof(uint32_t)];
+
+void
+BitstreamBounceTail(Bitstream * const bs)
+{
+	const uint8_t *tail = (const uint8_t *)bs->rdtail;
+	const size_t n = (tail < bs->rdend) ? (size_t)(bs->rdend - tail) : 0;
+
+	bs->rdbase += 8 * (int32_t)(tail - (const uint8_t *)bs->rdbuf);
+
+	/* the tail may already be in bs_bounce */
+	memmove(bs_bounce, tail, n);
+	memset((uint8_t *)bs_bounce + n, 0, sizeof(bs_bounce) - n);
+
+	bs->rdbuf = bs->rdtail = bs_bounce;
+	bs->rdend = (const uint8_t *)bs_bounce + n;
+	bs->rdguard = (const uint8_t *)bs_bounce + XVID_BS_BOUNCE_MARGIN;
+}
+
 static const uint8_t log2_tab_16[16] =  { 0, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
  
 static uint32_t __inline log2bin(uint32_t value)
@@ -403,6 +424,7 @@ BitstreamReadHeaders(Bitstream * bs,
 
 	while ((BitstreamPos(bs) >> 3) + 4 <= bs->length) {
 
+		BitstreamCheckTail(bs);
 		BitstreamByteAlign(bs);
 		start_code = BitstreamShowBits(bs, 32);
 
@@ -794,8 +816,10 @@ BitstreamReadHeaders(Bitstream * bs,
 			DPRINTF(XVID_DEBUG_HEADER, "coding_type %i\n", coding_type);
 
 			/*********************** for decode B-frame time ***********************/
-			while (BitstreamGetBit(bs) != 0)	/* time_base */
+			while (BitstreamGetBit(bs) != 0) {	/* time_base */
 				time_incr++;
+				BitstreamCheckTail(bs);
+			}
 
 			READ_MARKER();
 
@@ -167,13 +167,30 @@ void write_video_packet_header(Bitstream * const bs,
  * Bitstream
  ****************************************************************************/
 
-/* Input buffer should be readable as full chunks of 8bytes, including
-the end of the buffer. Padding might be appropriate. If only chunks
-of 4bytes are applicable, define XVID_SAFE_BS_TAIL. Note that this will
-slow decoding, so consider this as a last-resort solution */
-#ifndef XVID_HAVE_PADDED_BS_BUFFER
-#define XVID_SAFE_BS_TAIL
+/* The reader keeps up to 64 bits of the stream in a left aligned cache and
+loads the next 32-bit word whenever fewer than 32 are left, without checking
+for the end of the buffer. Input buffers need 16 readable bytes behind the
+data (the player's FILE_READ_BUFFER_PADDING is 32). A corrupt or
+truncated VOP can run much further than that, so the decoder calls
+BitstreamCheckTail() once per macroblock, and in the loops that skip a run of
+codes of any length (stuffing, time_base): within XVID_BS_BOUNCE_MARGIN bytes
+of the end the rest of the data is moved into a zero padded buffer, reads past
+the end then see zeros. */
+/* more than a macroblock can take, 6 blocks of 64 escape mode 3 coefficients
+ * (30 bits each) plus the macroblock header */
+#define XVID_BS_BOUNCE_MARGIN 2048
+
+void BitstreamBounceTail(Bitstream * const bs);
+
+static __inline uint32_t
+BitstreamLoadWord(const uint32_t * const p)
+{
+	uint32_t tmp = *p;
+#ifndef ARCH_IS_BIG_ENDIAN
+	BSWAP(tmp);
 #endif
+	return tmp;
+}
 
 /* initialise bitstream structure */
 
@@ -194,29 +211,34 @@ BitstreamInit(Bitstream * const bs,
 	adjbitstream = adjbitstream - bitpos;
 	bs->start = bs->tail = (uint32_t *) adjbitstream;
 
+	/* reader */
+	bs->rdbuf = bs->start;
+	bs->rdtail = bs->start + 2;
+	bs->rdend = (const uint8_t *)bitstream + length;
+	bs->rdguard = (length > XVID_BS_BOUNCE_MARGIN) ?
+		bs->rdend - XVID_BS_BOUNCE_MARGIN : (const uint8_t *)bs->rdbuf;
+	bs->rdbase = -8 * (int32_t)bitpos;
+	bs->cache = ((uint64_t)BitstreamLoadWord(bs->start) << 32) | BitstreamLoadWord(bs->start + 1);
+	bs->cache <<= 8 * bitpos;
+	bs->bits = 64 - 8 * (uint32_t)bitpos;
+
+	/* writer */
 	tmp = *bs->start;
 #ifndef ARCH_IS_BIG_ENDIAN
 	BSWAP(tmp);
 #endif
-	bs->bufa = tmp;
-
-	tmp = *(bs->start + 1);
-#ifndef ARCH_IS_BIG_ENDIAN
-	BSWAP(tmp);
-#endif
-	bs->bufb = tmp;
 
 	bs->pos = bs->initpos = (uint32_t) bitpos*8;
 	/* preserve the intervening bytes */
 	if (bs->initpos > 0)
-		bs->buf = bs->bufa & (0xffffffff << (32 - bs->initpos));
+		bs->buf = tmp & (0xffffffff << (32 - bs->initpos));
 	else
 		bs->buf = 0;
 	bs->length = length;
 }
 
 
-/* reset bitstream state */
+/* reset the writer */
 
 static void __inline
 BitstreamReset(Bitstream * const bs)
@@ -229,79 +251,58 @@ BitstreamReset(Bitstream * const bs)
 #ifndef ARCH_IS_BIG_ENDIAN
 	BSWAP(tmp);
 #endif
-	bs->bufa = tmp;
-
-	tmp = *(bs->start + 1);
-#ifndef ARCH_IS_BIG_ENDIAN
-	BSWAP(tmp);
-#endif
-	bs->bufb = tmp;
 
 	/* preserve the intervening bytes */
 	if (bs->initpos > 0)
-		bs->buf = bs->bufa & (0xffffffff << (32 - bs->initpos));
+		bs->buf = tmp & (0xffffffff << (32 - bs->initpos));
 	else
 		bs->buf = 0;
 	bs->pos = bs->initpos;
 }
 
 
-/* reads n bits from bitstream without changing the stream pos */
+/* reads n bits (1..32) from bitstream without changing the stream pos */
 
 static uint32_t __inline
 BitstreamShowBits(Bitstream * const bs,
 				  const uint32_t bits)
 {
-	int nbit = (bits + bs->pos) - 32;
-
-	if (nbit > 0) {
-		return ((bs->bufa & (0xffffffff >> bs->pos)) << nbit) | (bs->
-																 bufb >> (32 -
-																		  nbit));
-	} else {
-		return (bs->bufa & (0xffffffff >> bs->pos)) >> (32 - bs->pos - bits);
-	}
+	return (uint32_t)(bs->cache >> (64 - bits));
 }
 
 
-/* skip n bits forward in bitstream */
+/* skip n bits (up to 32) forward in bitstream */
 
 static __inline void
 BitstreamSkip(Bitstream * const bs,
 			  const uint32_t bits)
 {
-	bs->pos += bits;
+	bs->cache <<= bits;
+	bs->bits -= bits;
 
-	if (bs->pos >= 32) {
-		uint32_t tmp;
-
-		bs->bufa = bs->bufb;
-#if defined(XVID_SAFE_BS_TAIL)
-		if (bs->tail<(bs->start+((bs->length+3)>>2)))
-#endif
-		{
-			tmp = *((uint32_t *) bs->tail + 2);
-#ifndef ARCH_IS_BIG_ENDIAN
-			BSWAP(tmp);
-#endif
-			bs->bufb = tmp;
-			bs->tail++;
-		}
-#if defined(XVID_SAFE_BS_TAIL)
-		else {
-			bs->bufb = 0;
-		}
-#endif
-		bs->pos -= 32;
+	if (bs->bits < 32) {
+		bs->cache |= ((uint64_t)BitstreamLoadWord(bs->rdtail++) << 32) >> bs->bits;
+		bs->bits += 32;
 	}
 }
 
 
+/* called once per macroblock, keeps the unchecked refill inside the buffer */
+
+static __inline void
+BitstreamCheckTail(Bitstream * const bs)
+{
+	if ((const uint8_t *)bs->rdtail > bs->rdguard)
+		BitstreamBounceTail(bs);
+}
+
+
 /* number of bits to next byte alignment */
 static __inline uint32_t
 BitstreamNumBitsToByteAlign(Bitstream *bs)
 {
-	uint32_t n = (32 - bs->pos) % 8;
+	/* rdbase and the loaded words are whole bytes */
+	uint32_t n = bs->bits % 8;
 	return n == 0 ? 8 : n;
 }
 
@@ -310,19 +311,13 @@ BitstreamNumBitsToByteAlign(Bitstream *bs)
 static __inline uint32_t
 BitstreamShowBitsFromByteAlign(Bitstream *bs, int bits)
 {
-	int bspos = bs->pos + BitstreamNumBitsToByteAlign(bs);
-	int nbit = (bits + bspos) - 32;
-
-	if (bspos >= 32) {
-		return bs->bufb >> (32 - nbit);
-	} else	if (nbit > 0) {
-		return ((bs->bufa & (0xffffffff >> bspos)) << nbit) | (bs->
-																 bufb >> (32 -
-																		  nbit));
-	} else {
-		return (bs->bufa & (0xffffffff >> bspos)) >> (32 - bspos - bits);
-	}
+	const uint32_t skip = BitstreamNumBitsToByteAlign(bs);
+	uint64_t cache = bs->cache;
 
+	if (skip + bits > bs->bits)
+		cache |= ((uint64_t)BitstreamLoadWord(bs->rdtail) << 32) >> bs->bits;
+
+	return (uint32_t)((cache << skip) >> (64 - bits));
 }
 
 
@@ -332,20 +327,25 @@ BitstreamShowBitsFromByteAlign(Bitstream *bs, int bits)
 static __inline void
 BitstreamByteAlign(Bitstream * const bs)
 {
-	uint32_t remainder = bs->pos % 8;
+	uint32_t remainder = bs->bits % 8;
 
 	if (remainder) {
-		BitstreamSkip(bs, 8 - remainder);
+		BitstreamSkip(bs, remainder);
 	}
 }
 
 
-/* bitstream length (unit bits) */
+/* bitstream position (unit bits). A Bitstream is either read or written,
+ * the other half of the state stays at its initial position (0). */
 
 static uint32_t __inline
 BitstreamPos(const Bitstream * const bs)
 {
-	return((uint32_t)(8*((ptr_t)bs->tail - (ptr_t)bs->start) + bs->pos - bs->initpos));
+	const int32_t read = bs->rdbase +
+		32 * (int32_t)(bs->rdtail - bs->rdbuf) - (int32_t)bs->bits;
+	const uint32_t written = (uint32_t)(8*((ptr_t)bs->tail - (ptr_t)bs->start) + bs->pos - bs->initpos);
+
+	return (uint32_t)read + written;
 }
 
 
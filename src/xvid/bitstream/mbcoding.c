@@ -37,6 +37,7 @@
 
 #include "../utils/mbfunctions.h"
 #include "../utils/sram_tables.h"
+#include "../utils/sram_plan.h"
 
 #ifdef _DEBUG
 # include "../motion/estimation.h"
@@ -47,11 +48,91 @@
 
 #define LEVELOFFSET 32
 
+/* Coefficient decode tables, [0] inter, [1] intra. 256 entries indexed by
+ * the first COEFF_BITS1 bits of the code, followed by 16 entry second level
+ * tables for the codes that are longer (up to 12 bits + sign). One 32-bit
+ * entry holds everything get_coeff needs, including the escape mode 1/2
+ * offsets, about 2 KB per table so both fit in SRAM. */
+#define COEFF_BITS1 8
+#define COEFF_BITS2 4
+
+#define COEFF_LEN(e)       ((e) & 0x1f)			/* code + sign bit */
+#define COEFF_LAST(e)      (((e) >> 5) & 1)
+#define COEFF_RUN(e)       (((e) >> 6) & 0x3f)
+#define COEFF_LEVEL(e)     (((e) >> 12) & 0x1f)	/* 0 for invalid codes */
+#define COEFF_ESC_LEVEL(e) (((e) >> 17) & 0x1f)	/* max_level[last][run], added in escape mode 1 */
+#define COEFF_ESC_RUN(e)   (((e) >> 22) & 0x3f)	/* max_run[last][level] + 1, added in escape mode 2 */
+#define COEFF_SUBTABLE     (1u << 28)			/* low 16 bits: index of the second level table */
+#define COEFF_ESCAPE       (1u << 29)
+
 /* Initialized once during xvid_global call
  * RO access is thread safe */
-static REVERSE_EVENT *DCT3D[2];
+static uint32_t *coeff_tables[2];
 static VLC coeff_VLC[2][2][64][64];
 
+static void
+init_coeff_tables(void)
+{
+	uint32_t intra, i, j;
+
+	for (intra = 0; intra < 2; intra++) {
+		uint32_t *tab;
+		uint32_t subtables = 0;
+
+		/* first level slots that need a second level table */
+		uint8_t has_subtable[1 << COEFF_BITS1];
+		memset(has_subtable, 0, sizeof(has_subtable));
+		for (i = 0; i < 102; i++) {
+			const VLC vlc = coeff_tab[intra][i].vlc;
+			if (vlc.len > COEFF_BITS1 && !has_subtable[vlc.code >> (vlc.len - COEFF_BITS1)]) {
+				has_subtable[vlc.code >> (vlc.len - COEFF_BITS1)] = 1;
+				subtables++;
+			}
+		}
+
+		if (coeff_tables[intra] == NULL) {
+			coeff_tables[intra] = (uint32_t*)xvid_malloc_planned(intra ? SRAM_DCT3D_INTRA : SRAM_DCT3D_INTER,
+				sizeof(uint32_t) * ((1 << COEFF_BITS1) + (subtables << COEFF_BITS2)), CACHE_LINE);
+		}
+		tab = coeff_tables[intra];
+		memset(tab, 0, sizeof(uint32_t) * ((1 << COEFF_BITS1) + (subtables << COEFF_BITS2)));
+
+		subtables = 0;
+		for (i = 0; i < (1 << COEFF_BITS1); i++) {
+			if (has_subtable[i]) {
+				tab[i] = COEFF_SUBTABLE | ((1 << COEFF_BITS1) + (subtables++ << COEFF_BITS2));
+			}
+		}
+
+		/* ESCAPE is 7 bits, all of its first level slots */
+		for (j = 0; j < (1u << (COEFF_BITS1 - 7)); j++) {
+			tab[(ESCAPE << (COEFF_BITS1 - 7)) | j] = COEFF_ESCAPE;
+		}
+
+		for (i = 0; i < 102; i++) {
+			const VLC vlc = coeff_tab[intra][i].vlc;
+			const EVENT event = coeff_tab[intra][i].event;
+			const uint32_t entry = (vlc.len + 1) | (event.last << 5) | (event.run << 6) |
+				(event.level << 12) | (max_level[intra][event.last][event.run] << 17) |
+				((max_run[intra][event.last][event.level] + 1) << 22);
+			uint32_t *slots;
+			uint32_t bits;
+
+			if (vlc.len <= COEFF_BITS1) {
+				slots = &tab[vlc.code << (COEFF_BITS1 - vlc.len)];
+				bits = COEFF_BITS1 - vlc.len;
+			} else {
+				slots = &tab[(tab[vlc.code >> (vlc.len - COEFF_BITS1)] & 0xffff) +
+					((vlc.code << (COEFF_BITS1 + COEFF_BITS2 - vlc.len)) & ((1 << COEFF_BITS2) - 1))];
+				bits = COEFF_BITS1 + COEFF_BITS2 - vlc.len;
+			}
+			for (j = 0; j < (1u << bits); j++) {
+				slots[j] = entry;
+			}
+		}
+	}
+}
+
 /* not really MB related, but VLCs are only available here */
 void bs_put_spritetrajectory(Bitstream * bs, const int val)
 {
@@ -86,22 +167,11 @@ int bs_get_spritetrajectory(Bitstream * bs)
 void
 init_vlc_tables(void)
 {
-	uint32_t i, j, k, intra, last, run,  run_esc, level, level_esc, escape, escape_len, offset;
+	uint32_t i, k, intra, last, run,  run_esc, level, level_esc, escape, escape_len, offset;
 	int32_t l;
-    
-    /* Allocate DCT3D tables in SRAM (or fallback to SDRAM) */
-    if (DCT3D[0] == NULL) {
-        DCT3D[0] = (REVERSE_EVENT*)xvid_malloc_sram(sizeof(REVERSE_EVENT) * 4096, CACHE_LINE);
-        memset(DCT3D[0], 0, sizeof(REVERSE_EVENT) * 4096);
-    }
-    if (DCT3D[1] == NULL) {
-        DCT3D[1] = (REVERSE_EVENT*)xvid_malloc_sram(sizeof(REVERSE_EVENT) * 4096, CACHE_LINE);
-        memset(DCT3D[1], 0, sizeof(REVERSE_EVENT) * 4096);
-    }
-
-	for (intra = 0; intra < 2; intra++)
-		for (i = 0; i < 4096; i++)
-			DCT3D[intra][i].event.level = 0;
+
+	/* decode tables in SRAM (or fallback to SDRAM) */
+	init_coeff_tables();
 
 	for (intra = 0; intra < 2; intra++) {
 		for (last = 0; last < 2; last++) {
@@ -118,11 +188,6 @@ init_vlc_tables(void)
 		for (i = 0; i < 102; i++) {
 			offset = !intra * LEVELOFFSET;
 
-			for (j = 0; j < (uint32_t)(1 << (12 - coeff_tab[intra][i].vlc.len)); j++) {
-				DCT3D[intra][(coeff_tab[intra][i].vlc.code << (12 - coeff_tab[intra][i].vlc.len)) | j].len	 = coeff_tab[intra][i].vlc.len;
-				DCT3D[intra][(coeff_tab[intra][i].vlc.code << (12 - coeff_tab[intra][i].vlc.len)) | j].event = coeff_tab[intra][i].event;
-			}
-
 			coeff_VLC[intra][coeff_tab[intra][i].event.last][coeff_tab[intra][i].event.level + offset][coeff_tab[intra][i].event.run].code
 				= coeff_tab[intra][i].vlc.code << 1;
 			coeff_VLC[intra][coeff_tab[intra][i].event.last][coeff_tab[intra][i].event.level + offset][coeff_tab[intra][i].event.run].len
@@ -850,6 +915,7 @@ get_mcbpc_intra(Bitstream * bs)
 	index = BitstreamShowBits(bs, 9);
 	index >>= 3;
 
+	SRAM_COUNT(SRAM_MCBPC_INTRA, 1);
 	BitstreamSkip(bs, sram_mcbpc_intra_table[index].len);
 
 	return sram_mcbpc_intra_table[index].code;
@@ -864,6 +930,7 @@ get_mcbpc_inter(Bitstream * bs)
 
 	index = MIN(BitstreamShowBits(bs, 9), 256);
 
+	SRAM_COUNT(SRAM_MCBPC_INTER, 1);
 	BitstreamSkip(bs, sram_mcbpc_inter_table[index].len);
 
 	return sram_mcbpc_inter_table[index].code;
@@ -878,6 +945,7 @@ get_cbpy(Bitstream * bs,
 	int cbpy;
 	uint32_t index = BitstreamShowBits(bs, 6);
 
+	SRAM_COUNT(SRAM_CBPY, 1);
 	BitstreamSkip(bs, sram_cbpy_table[index].len);
 	cbpy = sram_cbpy_table[index].code;
 
@@ -901,18 +969,21 @@ get_mv_data(Bitstream * bs)
 
 	if (index >= 512) {
 		index = (index >> 8) - 2;
+		SRAM_COUNT(SRAM_TMNMV0, 1);
 		BitstreamSkip(bs, sram_TMNMVtab0[index].len);
 		return sram_TMNMVtab0[index].code;
 	}
 
 	if (index >= 128) {
 		index = (index >> 2) - 32;
+		SRAM_COUNT(SRAM_TMNMV1, 1);
 		BitstreamSkip(bs, sram_TMNMVtab1[index].len);
 		return sram_TMNMVtab1[index].code;
 	}
 
 	index -= 4;
 
+	SRAM_COUNT(SRAM_TMNMV2, 1);
 	BitstreamSkip(bs, sram_TMNMVtab2[index&0x7f].len);
 	return sram_TMNMVtab2[index&0x7f].code;
 
@@ -999,6 +1070,16 @@ get_dc_size_chrom(Bitstream * bs)
 
 #define GET_BITS(cache, n) ((cache)>>(32-(n)))
 
+static __inline uint32_t
+coeff_lookup(const uint32_t * const tab, const uint32_t cache)
+{
+	uint32_t e = tab[GET_BITS(cache, COEFF_BITS1)];
+
+	if (e & COEFF_SUBTABLE)
+		e = tab[(e & 0xffff) + (GET_BITS(cache, COEFF_BITS1 + COEFF_BITS2) & ((1 << COEFF_BITS2) - 1))];
+	return e;
+}
+
 static __inline int
 get_coeff(Bitstream * bs,
 		  int *run,
@@ -1007,30 +1088,33 @@ get_coeff(Bitstream * bs,
 		  int short_video_header)
 {
 
-	uint32_t mode;
+	uint32_t mode, skip, e;
 	int32_t level;
-	REVERSE_EVENT *reverse_event;
+	const uint32_t *tab;
 
 	uint32_t cache = BitstreamShowBits(bs, 32);
 	
 	if (short_video_header)		/* inter-VLCs will be used for both intra and inter blocks */
 		intra = 0;
 
-	if (GET_BITS(cache, 7) != ESCAPE) {
-		reverse_event = &DCT3D[intra][GET_BITS(cache, 12)];
+	tab = coeff_tables[intra];
+	e = coeff_lookup(tab, cache);
+	SRAM_COUNT(intra ? SRAM_DCT3D_INTRA : SRAM_DCT3D_INTER, 1);
 
-		if ((level = reverse_event->event.level) == 0)
-			goto error;
-
-		*last = reverse_event->event.last;
-		*run  = reverse_event->event.run;
+	/* escape and invalid codes have no level */
+	if ((level = COEFF_LEVEL(e)) != 0) {
+		*last = COEFF_LAST(e);
+		*run  = COEFF_RUN(e);
 
 		/* Don't forget to update the bitstream position */
-		BitstreamSkip(bs, reverse_event->len+1);
+		BitstreamSkip(bs, COEFF_LEN(e));
 
-		return (GET_BITS(cache, reverse_event->len+1)&0x01) ? -level : level;
+		return (GET_BITS(cache, COEFF_LEN(e))&0x01) ? -level : level;
 	}
 
+	if (!(e & COEFF_ESCAPE))
+		goto error;
+
 	/* flush 7bits of cache */
 	cache <<= 7;
 
@@ -1050,29 +1134,25 @@ get_coeff(Bitstream * bs,
 	}
 
 	if ((mode = GET_BITS(cache, 2)) < 3) {
-		const int skip[3] = {1, 1, 2};
-		cache <<= skip[mode];
+		/* escape modes 1 ('0') and 2 ('10'): a regular code whose level
+		 * (mode 1) or run (mode 2) is offset by the entry's escape field */
+		skip = 1 + (mode >> 1);
+		cache <<= skip;
 
-		reverse_event = &DCT3D[intra][GET_BITS(cache, 12)];
+		e = coeff_lookup(tab, cache);
 
-		if ((level = reverse_event->event.level) == 0)
+		/* also catches a second ESCAPE */
+		if ((level = COEFF_LEVEL(e)) == 0)
 			goto error;
 
-		*last = reverse_event->event.last;
-		*run  = reverse_event->event.run;
+		*last = COEFF_LAST(e);
+		*run  = COEFF_RUN(e) + ((mode >> 1) ? COEFF_ESC_RUN(e) : 0);
+		level += (mode >> 1) ? 0 : COEFF_ESC_LEVEL(e);
 
-		if (mode < 2) {
-			/* first escape mode, level is offset */
-			level += max_level[intra][*last][*run];
-		} else {
-			/* second escape mode, run is offset */
-			*run += max_run[intra][*last][level] + 1;
-		}
-		
 		/* Update bitstream position */
-		BitstreamSkip(bs, 7 + skip[mode] + reverse_event->len + 1);
+		BitstreamSkip(bs, 7 + skip + COEFF_LEN(e));
 
-		return (GET_BITS(cache, reverse_event->len+1)&0x01) ? -level : level;
+		return (GET_BITS(cache, COEFF_LEN(e))&0x01) ? -level : level;
 	}
 
 	/* third escape mode - fixed length codes */
@@ -1091,7 +1171,7 @@ get_coeff(Bitstream * bs,
 	return 0;
 }
 
-void
+int
 get_intra_block(Bitstream * bs,
 				int16_t * block,
 				int direction,
@@ -1100,6 +1180,7 @@ get_intra_block(Bitstream * bs,
 
 	const uint16_t *scan = scan_tables[direction];
 	int level, run, last = 0;
+	int last_pos = 0;
 
 	do {
 		level = get_coeff(bs, &run, &last, 1, 0);
@@ -1110,6 +1191,7 @@ get_intra_block(Bitstream * bs,
 		}
 
 		block[scan[coeff]] = level;
+		last_pos = coeff;
 
 		DPRINTF(XVID_DEBUG_COEFF,"block[%i] %i\n", scan[coeff], level);
 #if 0
@@ -1122,9 +1204,10 @@ get_intra_block(Bitstream * bs,
 		coeff++;
 	} while (!last);
 
+	return last_pos;
 }
 
-void
+int
 get_inter_block_h263(
 		Bitstream * bs,
 		int16_t * block,
@@ -1140,6 +1223,7 @@ get_inter_block_h263(
 	int level;
 	int run;
 	int last = 0;
+	int last_pos = 0;
 
 	p = 0;
 	do {
@@ -1157,11 +1241,14 @@ get_inter_block_h263(
 			level = level * quant_m_2 + quant_add;
 			block[scan[p]] = (level <= 2047 ? level : 2047);
 		}		
+		last_pos = p;
 		p++;
 	} while (!last);
+
+	return last_pos;
 }
 
-void
+int
 get_inter_block_mpeg(
 		Bitstream * bs,
 		int16_t * block,
@@ -1175,6 +1262,7 @@ get_inter_block_mpeg(
 	int level;
 	int run;
 	int last = 0;
+	int last_pos = 0;
 
 	p = 0;
 	do {
@@ -1185,6 +1273,7 @@ get_inter_block_mpeg(
 			break;
 		}
 
+		SRAM_COUNT(SRAM_QUANT_MATRICES, 1);
 		if (level < 0) {
 			level = ((2 * -level + 1) * matrix[scan[p]] * quant) >> 4;
 			block[scan[p]] = (level <= 2048 ? -level : -2048);
@@ -1195,13 +1284,17 @@ get_inter_block_mpeg(
 
 		sum ^= block[scan[p]];
 		
+		last_pos = p;
 		p++;
 	} while (!last);
 
 	/*	mismatch control */
 	if ((sum & 1) == 0) {
 		block[63] ^= 1;
+		last_pos = 63; /* 63 is the last position of every scan */
 	}
+
+	return last_pos;
 }
 
 
@@ -50,18 +50,19 @@ int get_dc_dif(Bitstream * bs,
 int get_dc_size_lum(Bitstream * bs);
 int get_dc_size_chrom(Bitstream * bs);
 
-void get_intra_block(Bitstream * bs,
+/* the block decoders return the last scan position they wrote, see idct_region() in decoder.c */
+int get_intra_block(Bitstream * bs,
 					 int16_t * block,
 					 int direction,
 					 int coeff);
-void get_inter_block_h263(
+int get_inter_block_h263(
 		Bitstream * bs,
 		int16_t * block,
 		int direction,
 		const int quant,
 		const uint16_t *matrix);
 
-void get_inter_block_mpeg(
+int get_inter_block_mpeg(
 		Bitstream * bs,
 		int16_t * block,
 		int direction,
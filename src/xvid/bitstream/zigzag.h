@@ -58,4 +58,10 @@ static const uint16_t scan_tables[3][64] = {
 	 38, 46, 54, 62, 39, 47, 55, 63}
 };
 
+/* last scan position that still lies in the first row, for each scan in scan_tables */
+static const uint8_t scan_row0_last[3] = { 1, 3, 0 };
+
+/* last scan position that still lies in the top left 4x4, the same for all three scans */
+#define SCAN_4X4_LAST 9
+
 #endif							/* _ZIGZAG_H_ */
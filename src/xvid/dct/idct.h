@@ -35,8 +35,34 @@ typedef idctFunc *idctFuncPtr;
 
 extern idctFuncPtr idct;
 
+/*
+ * Smallest region of the block holding all nonzero coefficients, chosen from
+ * the last scan position the block decoders return. The decoder's fused
+ * transforms below skip what is outside of it and are bit exact with
+ * simple_idct_c followed by transfer_16to8add/transfer_16to8copy.
+ */
+#define IDCT_REGION_DC   0	/* block[0] only, the result is one value */
+#define IDCT_REGION_ROW0 1	/* block[0..7] */
+#define IDCT_REGION_4X4  2	/* rows and columns 0..3 */
+#define IDCT_REGION_FULL 3
+
+static __inline int
+idct_region_union(const int a, const int b)
+{
+	if (a == b || b == IDCT_REGION_DC) return a;
+	if (a == IDCT_REGION_DC) return b;
+	return IDCT_REGION_FULL;
+}
+
 idctFunc idct_int32;
 idctFunc simple_idct_c;		/* Michael Niedermayer */
+int simple_idct_dc_c(const int16_t dc);
+
+/* inverse transform and add to / store into an 8x8 block of pixels, clamped */
+void simple_idct_add_c(uint8_t * const dst, const uint32_t stride,
+					   int16_t * const block, const int region);
+void simple_idct_put_c(uint8_t * const dst, const uint32_t stride,
+					   int16_t * const block, const int region);
 
 #ifdef ARCH_IS_ARM
 idctFunc idct_int32_arm;
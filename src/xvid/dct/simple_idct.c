@@ -32,6 +32,7 @@
  */
 
 #include "../portab.h"
+#include "../utils/mem_transfer.h"
 #include "idct.h"
 
 #if 0
@@ -247,3 +248,168 @@ void simple_idct_c(int16_t * const block)
         idctSparseCol(block + i);
     }
 }
+
+/*
+ * Sparse variants, bit exact with simple_idct_c for blocks whose nonzero
+ * coefficients all lie in the given region (see IDCT_REGION_*). A column with
+ * only col[0] set comes out as a constant, that is all the DC and first row
+ * cases need.
+ */
+
+static __inline int idctColDC(int16_t dc)
+{
+	return (W4 * (dc + ((1<<(COL_SHIFT-1))/W4))) >> COL_SHIFT;
+}
+
+/* value of every pixel of an inverse transformed block that only has block[0] */
+int simple_idct_dc_c(const int16_t dc)
+{
+	/* the row pass leaves (dc << 3) in 16 bits */
+	return idctColDC((int16_t)(dc << 3));
+}
+
+/*
+ * Fused variants for the decoder: the column pass adds its results to the
+ * predicted block (add) or stores them (put) with the same clamping as
+ * transfer_16to8add/transfer_16to8copy, instead of writing the int16 block
+ * back for a separate transfer. Only the row pass output stays in block.
+ */
+
+static __inline void
+idctStorePixel(uint8_t * const dst, const int16_t value, const int add)
+{
+	int16_t pixel = add ? (int16_t) (*dst + value) : value;
+
+	if (pixel < 0) {
+		pixel = 0;
+	} else if (pixel > 255) {
+		pixel = 255;
+	}
+	*dst = (uint8_t) pixel;
+}
+
+/* idctSparseCol() storing into column 0 of dst, rows4 if col[8*4..8*7] are known to be 0 */
+static __inline void
+idctSparseColStore(uint8_t * const dst, const uint32_t stride,
+				   const int16_t * const col, const int rows4, const int add)
+{
+	int a0, a1, a2, a3, b0, b1, b2, b3;
+
+	a0 = W4 * (col[8*0] + ((1<<(COL_SHIFT-1))/W4));
+	a1 = a0;
+	a2 = a0;
+	a3 = a0;
+
+	a0 +=  + W2*col[8*2];
+	a1 +=  + W6*col[8*2];
+	a2 +=  - W6*col[8*2];
+	a3 +=  - W2*col[8*2];
+
+	MUL16(b0, W1, col[8*1]);
+	MUL16(b1, W3, col[8*1]);
+	MUL16(b2, W5, col[8*1]);
+	MUL16(b3, W7, col[8*1]);
+
+	MAC16(b0, + W3, col[8*3]);
+	MAC16(b1, - W7, col[8*3]);
+	MAC16(b2, - W1, col[8*3]);
+	MAC16(b3, - W5, col[8*3]);
+
+	if (!rows4) {
+		if(col[8*4]){
+			a0 += + W4*col[8*4];
+			a1 += - W4*col[8*4];
+			a2 += - W4*col[8*4];
+			a3 += + W4*col[8*4];
+		}
+
+		if (col[8*5]) {
+			MAC16(b0, + W5, col[8*5]);
+			MAC16(b1, - W1, col[8*5]);
+			MAC16(b2, + W7, col[8*5]);
+			MAC16(b3, + W3, col[8*5]);
+		}
+
+		if(col[8*6]){
+			a0 += + W6*col[8*6];
+			a1 += - W2*col[8*6];
+			a2 += + W2*col[8*6];
+			a3 += - W6*col[8*6];
+		}
+
+		if (col[8*7]) {
+			MAC16(b0, + W7, col[8*7]);
+			MAC16(b1, - W5, col[8*7]);
+			MAC16(b2, + W3, col[8*7]);
+			MAC16(b3, - W1, col[8*7]);
+		}
+	}
+
+	idctStorePixel(dst + 0*stride, (int16_t) ((a0 + b0) >> COL_SHIFT), add);
+	idctStorePixel(dst + 1*stride, (int16_t) ((a1 + b1) >> COL_SHIFT), add);
+	idctStorePixel(dst + 2*stride, (int16_t) ((a2 + b2) >> COL_SHIFT), add);
+	idctStorePixel(dst + 3*stride, (int16_t) ((a3 + b3) >> COL_SHIFT), add);
+	idctStorePixel(dst + 4*stride, (int16_t) ((a3 - b3) >> COL_SHIFT), add);
+	idctStorePixel(dst + 5*stride, (int16_t) ((a2 - b2) >> COL_SHIFT), add);
+	idctStorePixel(dst + 6*stride, (int16_t) ((a1 - b1) >> COL_SHIFT), add);
+	idctStorePixel(dst + 7*stride, (int16_t) ((a0 - b0) >> COL_SHIFT), add);
+}
+
+static __inline void
+simple_idct_store(uint8_t * const dst, const uint32_t stride,
+				  int16_t * const block, const int region, const int add)
+{
+	int i, j;
+
+	switch (region) {
+	case IDCT_REGION_DC:
+		if (add)
+			transfer_16to8add_dc(dst, simple_idct_dc_c(block[0]), stride);
+		else
+			transfer_16to8copy_dc(dst, simple_idct_dc_c(block[0]), stride);
+		break;
+
+	case IDCT_REGION_ROW0:
+		/* every column is a constant */
+		idctRowCondDC(block);
+		for (i = 0; i < 8; i++) {
+			const int16_t value = idctColDC(block[i]);
+			for (j = 0; j < 8; j++) {
+				idctStorePixel(dst + j*stride + i, value, add);
+			}
+		}
+		break;
+
+	case IDCT_REGION_4X4:
+		for (i = 0; i < 4; i++) {
+			idctRowCondDC(block + i*8);
+		}
+		for (i = 0; i < 8; i++) {
+			idctSparseColStore(dst + i, stride, block + i, 1, add);
+		}
+		break;
+
+	default:
+		for (i = 0; i < 8; i++) {
+			idctRowCondDC(block + i*8);
+		}
+		for (i = 0; i < 8; i++) {
+			idctSparseColStore(dst + i, stride, block + i, 0, add);
+		}
+		break;
+	}
+}
+
+/* dst += idct(block), clamped. block is left with the row pass output */
+void simple_idct_add_c(uint8_t * const dst, const uint32_t stride,
+					   int16_t * const block, const int region)
+{
+	simple_idct_store(dst, stride, block, region, 1);
+}
+
+/* dst = idct(block), clamped */
+void simple_idct_put_c(uint8_t * const dst, const uint32_t stride,
+					   int16_t * const block, const int region)
+{
+	simple_idct_store(dst, stride, block, region, 0);
+}
@@ -50,6 +50,7 @@
 #include "image/qpel.h"
 
 #include "bitstream/mbcoding.h"
+#include "bitstream/zigzag.h"
 #include "prediction/mbprediction.h"
 #include "utils/timer.h"
 #include "utils/emms.h"
@@ -61,55 +62,112 @@
 #include "image/postprocessing.h"
 #include "utils/mem_align.h"
 #include "utils/sram_tables.h"
+#include "utils/sram_plan.h"
 
 #define DIV2ROUND(n)  (((n)>>1)|((n)&1))
 #define DIV2(n)       ((n)>>1)
 #define DIVUVMOV(n) (((n) >> 1) + sram_roundtab_79[(n) & 0x3]) //
 
+/* gives refn[1] its own planes back, the buffers can be freed one by one */
+static void
+decoder_unshare_refs(DECODER * dec)
+{
+  if (dec->refn_shared) {
+    dec->refn[1] = dec->spare;
+    image_null(&dec->spare);
+    dec->refn_shared = 0;
+  }
+}
+
+/* refn[1], the older reference, is only read by B-VOPs. Without it the
+   references rotate through cur and refn[0] alone, see decoder_rotate_refs().
+   Allocated once a VOL allows B-VOPs or one turns up anyway */
+static int
+decoder_alloc_bvop_refs(DECODER * dec)
+{
+  IMAGE img;
+
+  if (dec->refn[1].y != NULL)
+    return 0;
+
+  image_null(&img);
+  if (image_create_noedge(&img, dec->edged_width, dec->edged_height))
+    return XVID_ERR_MEMORY;
+
+  if (dec->cur_is_ref) {
+    /* cur holds the VOP before refn[0], which is what refn[1] would be */
+    dec->refn[1] = dec->cur;
+    dec->cur = img;
+    dec->cur_is_ref = 0;
+  } else {
+    dec->refn[1] = img;
+    image_copy(&dec->refn[1], &dec->refn[0], dec->edged_width, dec->height);
+  }
+  return 0;
+}
+
+/* dec->tmp only holds postprocessed pictures, allocated when postprocessing is
+   first asked for. Without it pictures are output unprocessed */
+static int
+decoder_alloc_tmp(DECODER * dec)
+{
+  if (dec->tmp.y != NULL)
+    return 0;
+  return image_create_noedge(&dec->tmp, dec->edged_width, dec->edged_height);
+}
+
 static int
 decoder_resize(DECODER * dec)
 {
 	/* free existing */
-	image_destroy(&dec->cur, dec->edged_width, dec->edged_height);
-	image_destroy(&dec->refn[0], dec->edged_width, dec->edged_height);
-	image_destroy(&dec->refn[1], dec->edged_width, dec->edged_height);
-	image_destroy(&dec->tmp, dec->edged_width, dec->edged_height);
-	image_destroy(&dec->qtmp, dec->edged_width, dec->edged_height);
-
-	image_destroy(&dec->gmc, dec->edged_width, dec->edged_height);
+	decoder_unshare_refs(dec);
+	image_destroy_noedge(&dec->cur, dec->edged_width, dec->edged_height);
+	image_destroy_noedge(&dec->refn[0], dec->edged_width, dec->edged_height);
+	image_destroy_noedge(&dec->refn[1], dec->edged_width, dec->edged_height);
+	image_destroy_noedge(&dec->tmp, dec->edged_width, dec->edged_height);
 
   image_null(&dec->cur);
   image_null(&dec->refn[0]);
   image_null(&dec->refn[1]);
   image_null(&dec->tmp);
-  image_null(&dec->qtmp);
-  image_null(&dec->gmc);
 
 
   xvid_free(dec->last_mbs);
   xvid_free(dec->mbs);
   xvid_free(dec->qscale);
+  xvid_free(dec->mb_static);
+  xvid_free(dec->edge_block);
   dec->last_mbs = NULL;
   dec->mbs = NULL;
   dec->qscale = NULL;
+  dec->mb_static = NULL;
+  dec->edge_block = NULL;
+  dec->cur_is_ref = 0;
+  dec->last_output = NULL;
 
 	/* realloc */
 	dec->mb_width = (dec->width + 15) / 16;
 	dec->mb_height = (dec->height + 15) / 16;
 
-	dec->edged_width = 16 * dec->mb_width + 2 * EDGE_SIZE;
-	dec->edged_height = 16 * dec->mb_height + 2 * EDGE_SIZE;
+	dec->edged_width = 16 * dec->mb_width;
+	dec->edged_height = 16 * dec->mb_height;
+	dec->pad_width = dec->edged_width;
+	dec->pad_height = dec->edged_height;
 
-	if (   image_create(&dec->cur, dec->edged_width, dec->edged_height) 
-	    || image_create(&dec->refn[0], dec->edged_width, dec->edged_height)
-	    || image_create(&dec->refn[1], dec->edged_width, dec->edged_height) 	/* Support B-frame to reference last 2 frame */
-	    || image_create(&dec->tmp, dec->edged_width, dec->edged_height)
-	    || image_create(&dec->qtmp, dec->edged_width, dec->edged_height)
-      || image_create(&dec->gmc, dec->edged_width, dec->edged_height) )
+	/* refn[1] and tmp follow when a stream needs them, see
+	 * decoder_alloc_bvop_refs() and decoder_alloc_tmp() */
+	if (   image_create_noedge(&dec->cur, dec->edged_width, dec->edged_height) 
+	    || image_create_noedge(&dec->refn[0], dec->edged_width, dec->edged_height) )
     goto memory_error;
 
+	/* a 16x16 block's 17 rows at the plane pitch (or a field block's 9 rows
+	 * at twice the pitch), plus room for kernels that read ahead */
+	dec->edge_block = xvid_malloc(17 * dec->edged_width + 64, CACHE_LINE);
+	if (dec->edge_block == NULL)
+	  goto memory_error;
+
 	dec->mbs =
-		xvid_malloc_sram(sizeof(MACROBLOCK) * dec->mb_width * dec->mb_height,
+		xvid_malloc_planned(SRAM_MBS, sizeof(MACROBLOCK) * dec->mb_width * dec->mb_height,
 					CACHE_LINE);
 	if (dec->mbs == NULL)
 	  goto memory_error;
@@ -117,15 +175,20 @@ decoder_resize(DECODER * dec)
 
 	/* For skip MB flag */
 	dec->last_mbs =
-		xvid_malloc_sram(sizeof(MACROBLOCK) * dec->mb_width * dec->mb_height,
+		xvid_malloc_planned(SRAM_MBS, sizeof(MACROBLOCK) * dec->mb_width * dec->mb_height,
 					CACHE_LINE);
 	if (dec->last_mbs == NULL)
 	  goto memory_error;
 	memset(dec->last_mbs, 0, sizeof(MACROBLOCK) * dec->mb_width * dec->mb_height);
 
+	dec->mb_static = xvid_malloc(dec->mb_width * dec->mb_height, CACHE_LINE);
+	if (dec->mb_static == NULL)
+	  goto memory_error;
+	memset(dec->mb_static, 0, dec->mb_width * dec->mb_height);
+
 	/* nothing happens if that fails */
 	dec->qscale =
-		xvid_malloc_sram(sizeof(int) * dec->mb_width * dec->mb_height, CACHE_LINE);
+		xvid_malloc_planned(SRAM_QSCALE, sizeof(int) * dec->mb_width * dec->mb_height, CACHE_LINE);
 	
 	if (dec->qscale)
 		memset(dec->qscale, 0, sizeof(int) * dec->mb_width * dec->mb_height);
@@ -136,11 +199,12 @@ memory_error:
         /* Most structures were deallocated / nullifieded, so it should be safe */
         /* decoder_destroy(dec) minus the write_timer */
   xvid_free(dec->mbs);
-  image_destroy(&dec->cur, dec->edged_width, dec->edged_height);
-  image_destroy(&dec->refn[0], dec->edged_width, dec->edged_height);
-  image_destroy(&dec->refn[1], dec->edged_width, dec->edged_height);
-  image_destroy(&dec->tmp, dec->edged_width, dec->edged_height);
-  image_destroy(&dec->qtmp, dec->edged_width, dec->edged_height);
+  xvid_free(dec->mb_static);
+  xvid_free(dec->edge_block);
+  image_destroy_noedge(&dec->cur, dec->edged_width, dec->edged_height);
+  image_destroy_noedge(&dec->refn[0], dec->edged_width, dec->edged_height);
+  image_destroy_noedge(&dec->refn[1], dec->edged_width, dec->edged_height);
+  image_destroy_noedge(&dec->tmp, dec->edged_width, dec->edged_height);
 
   xvid_free(dec);
   return XVID_ERR_MEMORY;
@@ -163,7 +227,7 @@ decoder_create(xvid_dec_create_t * create)
 
   memset(dec, 0, sizeof(DECODER));
 
-  dec->mpeg_quant_matrices = xvid_malloc_sram(sizeof(uint16_t) * 64 * 8, CACHE_LINE);
+  dec->mpeg_quant_matrices = xvid_malloc_planned(SRAM_QUANT_MATRICES, sizeof(uint16_t) * 64 * 8, CACHE_LINE);
   if (dec->mpeg_quant_matrices == NULL) {
     xvid_free(dec);
     return XVID_ERR_MEMORY;
@@ -171,8 +235,8 @@ decoder_create(xvid_dec_create_t * create)
 
   /* Allocate SRAM scratch buffers for macroblock decoding */
   /* 6 blocks * 64 coefficients * sizeof(int16_t) */
-  dec->sram_scratch_block = xvid_malloc_sram(6 * 64 * sizeof(int16_t), CACHE_LINE);
-  dec->sram_scratch_data = xvid_malloc_sram(6 * 64 * sizeof(int16_t), CACHE_LINE);
+  dec->sram_scratch_block = xvid_malloc_planned(SRAM_SCRATCH_BLOCK, 6 * 64 * sizeof(int16_t), CACHE_LINE);
+  dec->sram_scratch_data = xvid_malloc_planned(SRAM_SCRATCH_DATA, 6 * 64 * sizeof(int16_t), CACHE_LINE);
   
   if (dec->sram_scratch_block == NULL || dec->sram_scratch_data == NULL) {
 	  xvid_free(dec->mpeg_quant_matrices);
@@ -192,20 +256,18 @@ decoder_create(xvid_dec_create_t * create)
   image_null(&dec->cur);
   image_null(&dec->refn[0]);
   image_null(&dec->refn[1]);
+  image_null(&dec->spare);
   image_null(&dec->tmp);
-  image_null(&dec->qtmp);
-
-  /* image based GMC */
-  image_null(&dec->gmc);
 
   dec->mbs = NULL;
   dec->last_mbs = NULL;
   dec->qscale = NULL;
+  dec->mb_static = NULL;
+  dec->edge_block = NULL;
 
   init_timer();
   init_postproc(&dec->postproc);
   init_mpeg_matrix(dec->mpeg_quant_matrices);
-  init_sram_tables();
 
   /* For B-frame support (used to save reference frame's time */
   dec->frames = 0;
@@ -235,18 +297,18 @@ decoder_create(xvid_dec_create_t * create)
 int
 decoder_destroy(DECODER * dec)
 {
+  decoder_unshare_refs(dec);
+
   xvid_free(dec->last_mbs);
   xvid_free(dec->mbs);
   xvid_free(dec->qscale);
+  xvid_free(dec->mb_static);
+  xvid_free(dec->edge_block);
 
-  /* image based GMC */
-  image_destroy(&dec->gmc, dec->edged_width, dec->edged_height);
-
-  image_destroy(&dec->refn[0], dec->edged_width, dec->edged_height);
-  image_destroy(&dec->refn[1], dec->edged_width, dec->edged_height);
-  image_destroy(&dec->tmp, dec->edged_width, dec->edged_height);
-  image_destroy(&dec->qtmp, dec->edged_width, dec->edged_height);
-  image_destroy(&dec->cur, dec->edged_width, dec->edged_height);
+  image_destroy_noedge(&dec->refn[0], dec->edged_width, dec->edged_height);
+  image_destroy_noedge(&dec->refn[1], dec->edged_width, dec->edged_height);
+  image_destroy_noedge(&dec->tmp, dec->edged_width, dec->edged_height);
+  image_destroy_noedge(&dec->cur, dec->edged_width, dec->edged_height);
   xvid_free(dec->mpeg_quant_matrices);
   xvid_free(dec->sram_scratch_block);
   xvid_free(dec->sram_scratch_data);
@@ -260,6 +322,19 @@ static const int32_t dquant_table[4] = {
   -1, -2, 1, 2
 };
 
+/* region of the block holding every coefficient up to scan position last */
+static __inline int
+idct_region(const int direction, const int last)
+{
+  if (last == 0)
+    return IDCT_REGION_DC;
+  if (last <= scan_row0_last[direction])
+    return IDCT_REGION_ROW0;
+  if (last <= SCAN_4X4_LAST)
+    return IDCT_REGION_4X4;
+  return IDCT_REGION_FULL;
+}
+
 /* decode an intra macroblock */
 static void
 decoder_mbintra(DECODER * dec,
@@ -278,6 +353,9 @@ decoder_mbintra(DECODER * dec,
   int16_t *data = dec->sram_scratch_data;
   
   memset(block, 0, 6 * 64 * sizeof(int16_t)); /* clear */
+  /* cleared and read back, dequantized into data and read by the idct */
+  SRAM_COUNT(SRAM_SCRATCH_BLOCK, 2 * 6 * 64);
+  SRAM_COUNT(SRAM_SCRATCH_DATA, 2 * 6 * 64);
 
   uint32_t stride = dec->edged_width;
   uint32_t stride2 = stride / 2;
@@ -285,17 +363,32 @@ decoder_mbintra(DECODER * dec,
   uint32_t i;
   uint32_t iQuant = MAX(1, pMB->quant);
   uint8_t *pY_Cur, *pU_Cur, *pV_Cur;
+  uint8_t *dst[6];
 
   pY_Cur = dec->cur.y + (y_pos << 4) * stride + (x_pos << 4);
   pU_Cur = dec->cur.u + (y_pos << 3) * stride2 + (x_pos << 3);
   pV_Cur = dec->cur.v + (y_pos << 3) * stride2 + (x_pos << 3);
 
+  if (dec->interlacing && pMB->field_dct) {
+    next_block = stride;
+    stride *= 2;
+  }
+
+  dst[0] = pY_Cur;
+  dst[1] = pY_Cur + 8;
+  dst[2] = pY_Cur + next_block;
+  dst[3] = pY_Cur + 8 + next_block;
+  dst[4] = pU_Cur;
+  dst[5] = pV_Cur;
+
   /* block cleared above */
 
   for (i = 0; i < 6; i++) {
     uint32_t iDcScaler = get_dc_scaler(iQuant, i < 4);
     int16_t predictors[8];
     int start_coeff;
+    int last = 0;
+    int region;
 
     start_timer();
     predict_acdc(dec->mbs, x_pos, y_pos, dec->mb_width, i, &block[i * 64],
@@ -330,37 +423,30 @@ decoder_mbintra(DECODER * dec,
       int direction = dec->alternate_vertical_scan ?
         2 : pMB->acpred_directions[i];
 
-      get_intra_block(bs, &block[i * 64], direction, start_coeff);
+      last = get_intra_block(bs, &block[i * 64], direction, start_coeff);
     }
     stop_coding_timer();
 
+    /* ac prediction adds to the first row (1) or column (2), the scan direction follows it */
+    region = idct_region(dec->alternate_vertical_scan ? 2 : pMB->acpred_directions[i], last);
+    if (pMB->acpred_directions[i] == 1)
+      region = idct_region_union(region, IDCT_REGION_ROW0);
+    else if (pMB->acpred_directions[i] == 2)
+      region = IDCT_REGION_FULL;
+
     start_timer();
     if (dec->quant_type == 0) {
       add_acdc_dequant_h263(pMB, i, &data[i * 64], &block[i * 64], iQuant, iDcScaler, predictors, dec->bs_version);
     } else {
       add_acdc_dequant_mpeg(pMB, i, &data[i * 64], &block[i * 64], iQuant, iDcScaler, predictors, dec->mpeg_quant_matrices, dec->bs_version);
+      SRAM_COUNT(SRAM_QUANT_MATRICES, 64);
     }
     stop_iquant_timer();
 
     start_timer();
-    idct((short * const)&data[i * 64]);
+    simple_idct_put_c(dst[i], i < 4 ? stride : stride2, &data[i * 64], region);
     stop_idct_timer();
-
   }
-
-  if (dec->interlacing && pMB->field_dct) {
-    next_block = stride;
-    stride *= 2;
-  }
-
-  start_timer();
-  transfer_16to8copy(pY_Cur, &data[0 * 64], stride);
-  transfer_16to8copy(pY_Cur + 8, &data[1 * 64], stride);
-  transfer_16to8copy(pY_Cur + next_block, &data[2 * 64], stride);
-  transfer_16to8copy(pY_Cur + 8 + next_block, &data[3 * 64], stride);
-  transfer_16to8copy(pU_Cur, &data[4 * 64], stride2);
-  transfer_16to8copy(pV_Cur, &data[5 * 64], stride2);
-  stop_transfer_timer();
 }
 
 static void
@@ -378,17 +464,12 @@ decoder_mb_decode(DECODER * dec,
   int i;
   const uint32_t iQuant = MAX(1, pMB->quant);
   const int direction = dec->alternate_vertical_scan ? 2 : 0;
-  typedef void (*get_inter_block_function_t)(
+  typedef int (*get_inter_block_function_t)(
       Bitstream * bs,
       int16_t * block,
       int direction,
       const int quant,
       const uint16_t *matrix);
-  typedef void (*add_residual_function_t)(
-      uint8_t *predicted_block,
-      const int16_t *residual,
-      int stride);
-
   const get_inter_block_function_t get_inter_block = (dec->quant_type == 0)
     ? (get_inter_block_function_t)get_inter_block_h263
     : (get_inter_block_function_t)get_inter_block_mpeg;
@@ -396,7 +477,6 @@ decoder_mb_decode(DECODER * dec,
   uint8_t *dst[6];
   int strides[6];
 
-
   if (dec->interlacing && pMB->field_dct) {
     dst[0] = pY_Cur;
     dst[1] = pY_Cur + 8;
@@ -419,33 +499,48 @@ decoder_mb_decode(DECODER * dec,
     strides[5] = stride/2;
   }
 
-  /* Decode coeffs and dequantize */
-  start_timer();
+  /* one block at a time through the same 128 bytes of SRAM: decode and dequantize,
+     then inverse transform straight into the predicted pixels */
   for (i = 0; i < 6; i++) {
-    if (cbp & (1 << (5 - i))) {
-      memset(&data[i*64], 0, 64*sizeof(int16_t));
-      get_inter_block(bs, &data[i*64], direction, iQuant, get_inter_matrix(dec->mpeg_quant_matrices));
-    }
-  }
-  stop_coding_timer();
+    int last;
 
-  /* iDCT */
-  start_timer();
-  for (i = 0; i < 6; i++) {
-    if (cbp & (1 << (5 - i))) {
-      idct((short * const)&data[i*64]);
-    }
+    if (!(cbp & (1 << (5 - i))))
+      continue;
+
+    start_timer();
+    memset(data, 0, 64*sizeof(int16_t));
+    SRAM_COUNT(SRAM_SCRATCH_DATA, 2 * 64);
+    last = get_inter_block(bs, data, direction, iQuant, get_inter_matrix(dec->mpeg_quant_matrices));
+    stop_coding_timer();
+
+    start_timer();
+    simple_idct_add_c(dst[i], strides[i], data, idct_region(direction, last));
+    stop_idct_timer();
   }
-  stop_idct_timer();
+}
+
+/* parse the residual of a macroblock that is never shown, the coefficients are thrown away */
+static void
+decoder_mb_skip_residual(DECODER * dec,
+        const uint32_t cbp,
+        Bitstream * bs,
+        const MACROBLOCK * pMB)
+{
+  int16_t *data = dec->sram_scratch_data;
+  const uint32_t iQuant = MAX(1, pMB->quant);
+  const int direction = dec->alternate_vertical_scan ? 2 : 0;
+  int i;
 
-  /* Add residual */
   start_timer();
   for (i = 0; i < 6; i++) {
     if (cbp & (1 << (5 - i))) {
-      transfer_16to8add(dst[i], &data[i*64], strides[i]);
+      if (dec->quant_type == 0)
+        get_inter_block_h263(bs, data, direction, iQuant, get_inter_matrix(dec->mpeg_quant_matrices));
+      else
+        get_inter_block_mpeg(bs, data, direction, iQuant, get_inter_matrix(dec->mpeg_quant_matrices));
     }
   }
-  stop_transfer_timer();
+  stop_coding_timer();
 }
 
 static void __inline
@@ -488,6 +583,85 @@ validate_vector(VECTOR * mv, unsigned int x_pos, unsigned int y_pos, const DECOD
  * So we try to be backward compatible to avoid artifacts */
 #define BS_VERSION_BUGGY_CHROMA_ROUNDING 1
 
+/* the size reference frames are padded from, see image_padded_size() */
+static void
+decoder_set_padding(DECODER * dec)
+{
+  dec->pad_width = dec->width;
+  dec->pad_height = dec->height;
+  image_padded_size(&dec->pad_width, &dec->pad_height, dec->bs_version);
+}
+
+#define MC_ADD   1  /* average with the prediction in cur, B-VOP backward */
+#define MC_QPEL  2  /* dx, dy are in quarterpel units */
+
+/* motion compensates a 16x16, 8x8 or 8x4 block from the reference plane ref
+ * into cur, the block's destination. (x, y) is the block's position in ref,
+ * its rows are step plane rows apart (2 for a field, y being the frame row
+ * of its first line). The reference planes have no edges: blocks reading
+ * outside the padded picture are copied to edge_block with the edge pixels
+ * repeated and compensated from there */
+static void
+decoder_mc(DECODER * dec,
+        uint8_t * const cur,
+        uint8_t * const ref,
+        const uint32_t stride,
+        const int chroma,
+        const int x,
+        const int y,
+        const int step,
+        const int dx,
+        const int dy,
+        const int w,
+        const int h,
+        const uint32_t rounding,
+        const int flags)
+{
+  const int shift = (flags & MC_QPEL) ? 2 : 1;
+  const int fdx = dx & ((1 << shift) - 1);
+  const int fdy = dy & ((1 << shift) - 1);
+  /* the pixels the kernels read, from the integer vector on */
+  const int bx = x + (dx >> shift);
+  const int by = y + step * (dy >> shift);
+  const int bw = w + (fdx != 0);
+  const int bh = h + (fdy != 0);
+  const int width = dec->pad_width >> chroma;
+  const int height = dec->pad_height >> chroma;
+  const uint32_t pitch = step * stride;
+  uint8_t *src;
+
+  if (bx >= 0 && by >= 0 && bx + bw <= width && by + (bh - 1) * step < height) {
+    src = ref + by * (int)stride + bx;
+  } else {
+    /* at the word alignment the block has in the plane, so aligned blocks
+     * still get the kernels' word-at-a-time path */
+    src = dec->edge_block + (bx & 3);
+    image_emulate_edges(src, pitch, ref, stride, width, height,
+                        bx, by, bw, bh, step);
+  }
+
+  /* the block is at src now, the kernels only see the fractional vector */
+  if (flags & MC_QPEL) {
+    const int quads = fdx | (fdy << 2);
+    if (w == 16)
+      ((flags & MC_ADD) ? xvid_QP_Block_Add_16 : xvid_QP_Block_16)[quads](cur, src, pitch, rounding);
+    else
+      ((flags & MC_ADD) ? xvid_QP_Block_Add_8 : xvid_QP_Block_8)[quads](cur, src, pitch, rounding);
+  } else if (w == 16) {
+    if (flags & MC_ADD)
+      interpolate16x16_add_switch(cur, src, 0, 0, fdx, fdy, pitch, rounding);
+    else
+      interpolate16x16_switch(cur, src, 0, 0, fdx, fdy, pitch, rounding);
+  } else if (h == 4) {
+    interpolate8x4_switch(cur, src, 0, 0, fdx, fdy, pitch, rounding);
+  } else {
+    if (flags & MC_ADD)
+      interpolate8x8_add_switch(cur, src, 0, 0, fdx, fdy, pitch, rounding);
+    else
+      interpolate8x8_switch(cur, src, 0, 0, fdx, fdy, pitch, rounding);
+  }
+}
+
 /* decode an inter macroblock */
 static void
 decoder_mbinter(DECODER * dec,
@@ -535,14 +709,10 @@ decoder_mbinter(DECODER * dec,
     }
     uv_dx = (uv_dx >> 1) + sram_roundtab_79[uv_dx & 0x3];
     uv_dy = (uv_dy >> 1) + sram_roundtab_79[uv_dy & 0x3];
+    SRAM_COUNT(SRAM_ROUNDTAB_79, 2);
 
-    if (dec->quarterpel)
-      interpolate16x16_quarterpel(dec->cur.y, dec->refn[ref].y, dec->qtmp.y, dec->qtmp.y + 64,
-                  dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
-                      mv[0].x, mv[0].y, stride, rounding);
-    else
-      interpolate16x16_switch(dec->cur.y, dec->refn[ref].y, 16*x_pos, 16*y_pos,
-                  mv[0].x, mv[0].y, stride, rounding);
+    decoder_mc(dec, pY_Cur, dec->refn[ref].y, stride, 0, 16*x_pos, 16*y_pos, 1,
+               mv[0].x, mv[0].y, 16, 16, rounding, dec->quarterpel ? MC_QPEL : 0);
 
   } else {  /* MODE_INTER4V */
 
@@ -566,37 +736,20 @@ decoder_mbinter(DECODER * dec,
 
     uv_dx = (uv_dx >> 3) + sram_roundtab_76[uv_dx & 0xf];
     uv_dy = (uv_dy >> 3) + sram_roundtab_76[uv_dy & 0xf];
+    SRAM_COUNT(SRAM_ROUNDTAB_76, 2);
 
-    if (dec->quarterpel) {
-      interpolate8x8_quarterpel(dec->cur.y, dec->refn[0].y , dec->qtmp.y, dec->qtmp.y + 64,
-                  dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
-                  mv[0].x, mv[0].y, stride, rounding);
-      interpolate8x8_quarterpel(dec->cur.y, dec->refn[0].y , dec->qtmp.y, dec->qtmp.y + 64,
-                  dec->qtmp.y + 128, 16*x_pos + 8, 16*y_pos,
-                  mv[1].x, mv[1].y, stride, rounding);
-      interpolate8x8_quarterpel(dec->cur.y, dec->refn[0].y , dec->qtmp.y, dec->qtmp.y + 64,
-                  dec->qtmp.y + 128, 16*x_pos, 16*y_pos + 8,
-                  mv[2].x, mv[2].y, stride, rounding);
-      interpolate8x8_quarterpel(dec->cur.y, dec->refn[0].y , dec->qtmp.y, dec->qtmp.y + 64,
-                  dec->qtmp.y + 128, 16*x_pos + 8, 16*y_pos + 8,
-                  mv[3].x, mv[3].y, stride, rounding);
-    } else {
-      interpolate8x8_switch(dec->cur.y, dec->refn[0].y , 16*x_pos, 16*y_pos,
-                mv[0].x, mv[0].y, stride, rounding);
-      interpolate8x8_switch(dec->cur.y, dec->refn[0].y , 16*x_pos + 8, 16*y_pos,
-                mv[1].x, mv[1].y, stride, rounding);
-      interpolate8x8_switch(dec->cur.y, dec->refn[0].y , 16*x_pos, 16*y_pos + 8,
-                mv[2].x, mv[2].y, stride, rounding);
-      interpolate8x8_switch(dec->cur.y, dec->refn[0].y , 16*x_pos + 8, 16*y_pos + 8,
-                mv[3].x, mv[3].y, stride, rounding);
+    for (i = 0; i < 4; i++) {
+      const int bx = 16*x_pos + 8*(i & 1), by = 16*y_pos + 8*(i >> 1);
+      decoder_mc(dec, dec->cur.y + by*stride + bx, dec->refn[0].y, stride, 0, bx, by, 1,
+                 mv[i].x, mv[i].y, 8, 8, rounding, dec->quarterpel ? MC_QPEL : 0);
     }
   }
 
   /* chroma */
-  interpolate8x8_switch(dec->cur.u, dec->refn[ref].u, 8 * x_pos, 8 * y_pos,
-              uv_dx, uv_dy, stride2, rounding);
-  interpolate8x8_switch(dec->cur.v, dec->refn[ref].v, 8 * x_pos, 8 * y_pos,
-              uv_dx, uv_dy, stride2, rounding);
+  decoder_mc(dec, pU_Cur, dec->refn[ref].u, stride2, 1, 8 * x_pos, 8 * y_pos, 1,
+             uv_dx, uv_dy, 8, 8, rounding, 0);
+  decoder_mc(dec, pV_Cur, dec->refn[ref].v, stride2, 1, 8 * x_pos, 8 * y_pos, 1,
+             uv_dx, uv_dy, 8, 8, rounding, 0);
 
   stop_comp_timer();
 
@@ -655,34 +808,34 @@ decoder_mbinter_field(DECODER * dec,
     else
     {
       /* Interpolate top field left part(we use double stride for every 2nd line) */
-      interpolate8x8_switch(dec->cur.y,dec->refn[ref].y+pMB->field_for_top*stride,
-                            16*x_pos,8*y_pos,mv[0].x, mv[0].y>>1,2*stride, rounding);
+      decoder_mc(dec, pY_Cur, dec->refn[ref].y, stride, 0,
+                 16*x_pos, 16*y_pos+pMB->field_for_top, 2, mv[0].x, mv[0].y>>1, 8, 8, rounding, 0);
       /* top field right part */
-      interpolate8x8_switch(dec->cur.y,dec->refn[ref].y+pMB->field_for_top*stride,
-                            16*x_pos+8,8*y_pos,mv[0].x, mv[0].y>>1,2*stride, rounding);
+      decoder_mc(dec, pY_Cur+8, dec->refn[ref].y, stride, 0,
+                 16*x_pos+8, 16*y_pos+pMB->field_for_top, 2, mv[0].x, mv[0].y>>1, 8, 8, rounding, 0);
 
       /* Interpolate bottom field left part(we use double stride for every 2nd line) */
-      interpolate8x8_switch(dec->cur.y+stride,dec->refn[ref].y+pMB->field_for_bot*stride,
-                            16*x_pos,8*y_pos,mv[1].x, mv[1].y>>1,2*stride, rounding);
+      decoder_mc(dec, pY_Cur+stride, dec->refn[ref].y, stride, 0,
+                 16*x_pos, 16*y_pos+pMB->field_for_bot, 2, mv[1].x, mv[1].y>>1, 8, 8, rounding, 0);
       /* Bottom field right part */
-      interpolate8x8_switch(dec->cur.y+stride,dec->refn[ref].y+pMB->field_for_bot*stride,
-                            16*x_pos+8,8*y_pos,mv[1].x, mv[1].y>>1,2*stride, rounding);
+      decoder_mc(dec, pY_Cur+stride+8, dec->refn[ref].y, stride, 0,
+                 16*x_pos+8, 16*y_pos+pMB->field_for_bot, 2, mv[1].x, mv[1].y>>1, 8, 8, rounding, 0);
 
       /* Interpolate field1 U */
-      interpolate8x4_switch(dec->cur.u,dec->refn[ref].u+pMB->field_for_top*stride2,
-                            8*x_pos,4*y_pos,uvtop_dx,DIV2ROUND(uvtop_dy),stride,rounding);
+      decoder_mc(dec, pU_Cur, dec->refn[ref].u, stride2, 1,
+                 8*x_pos, 8*y_pos+pMB->field_for_top, 2, uvtop_dx, DIV2ROUND(uvtop_dy), 8, 4, rounding, 0);
       
       /* Interpolate field1 V */
-      interpolate8x4_switch(dec->cur.v,dec->refn[ref].v+pMB->field_for_top*stride2,
-                            8*x_pos,4*y_pos,uvtop_dx,DIV2ROUND(uvtop_dy),stride,rounding);
+      decoder_mc(dec, pV_Cur, dec->refn[ref].v, stride2, 1,
+                 8*x_pos, 8*y_pos+pMB->field_for_top, 2, uvtop_dx, DIV2ROUND(uvtop_dy), 8, 4, rounding, 0);
     
       /* Interpolate field2 U */
-      interpolate8x4_switch(dec->cur.u+stride2,dec->refn[ref].u+pMB->field_for_bot*stride2,
-                            8*x_pos,4*y_pos,uvbot_dx,DIV2ROUND(uvbot_dy),stride,rounding);
+      decoder_mc(dec, pU_Cur+stride2, dec->refn[ref].u, stride2, 1,
+                 8*x_pos, 8*y_pos+pMB->field_for_bot, 2, uvbot_dx, DIV2ROUND(uvbot_dy), 8, 4, rounding, 0);
     
       /* Interpolate field2 V */
-      interpolate8x4_switch(dec->cur.v+stride2,dec->refn[ref].v+pMB->field_for_bot*stride2,
-                            8*x_pos,4*y_pos,uvbot_dx,DIV2ROUND(uvbot_dy),stride,rounding);
+      decoder_mc(dec, pV_Cur+stride2, dec->refn[ref].v, stride2, 1,
+                 8*x_pos, 8*y_pos+pMB->field_for_bot, 2, uvbot_dx, DIV2ROUND(uvbot_dy), 8, 4, rounding, 0);
     }
   } 
   else 
@@ -745,6 +898,64 @@ decoder_mbgmc(DECODER * dec,
 
 }
 
+/* XVID_CSP_SLICE together with a packed output: every macroblock row is converted
+   as soon as it is final, while it is still in the cache, instead of the whole
+   picture after decoding. Only for the picture this call returns, and not with
+   film effect or brightness, those work on the whole picture. Returns NULL when
+   decoder_output has to convert the picture as usual */
+static xvid_image_t *
+decoder_rows_output(DECODER * dec, xvid_dec_frame_t * frame)
+{
+  const int brightness = XVID_VERSION_MINOR(frame->version) >= 1 ? frame->brightness : 0;
+  const int csp = frame->output.csp & ~(XVID_CSP_VFLIP|XVID_CSP_ROTATE);
+
+  if (csp != (XVID_CSP_SLICE|XVID_CSP_RGB565) || (frame->general & XVID_DEC_PREROLL) ||
+    frame->output.plane[0] == NULL || frame->output.stride[0] < (int)dec->width)
+    return NULL;
+  if (((frame->general & XVID_FILMEFFECT) && !dec->cartoon_mode) || brightness != 0)
+    return NULL;
+
+  dec->out_rows_flags = frame->general & (XVID_DEBLOCKY|XVID_DEBLOCKUV|XVID_DERINGY|XVID_DERINGUV);
+  if ((dec->out_rows_flags & (XVID_DEBLOCKY|XVID_DEBLOCKUV)) && decoder_alloc_tmp(dec))
+    return NULL;
+  return &frame->output;
+}
+
+/* macroblock row mby of dec->cur is decoded. Without deblocking it's output right
+   away, otherwise it is deblocked in dec->tmp (cur is a reference) and the row
+   above is output, the edge between the two isn't filtered before now */
+static void
+decoder_output_row(DECODER * dec, int mby, int bvop)
+{
+  IMAGE * img = &dec->cur;
+  int first = mby, last = mby;
+  int r;
+
+  if (dec->out_rows_flags & (XVID_DEBLOCKY|XVID_DEBLOCKUV)) {
+    IMAGE src, dst;
+    const int y = mby << 4;
+    src.y = dec->cur.y + y * dec->edged_width;
+    src.u = dec->cur.u + (y >> 1) * (dec->edged_width >> 1);
+    src.v = dec->cur.v + (y >> 1) * (dec->edged_width >> 1);
+    dst.y = dec->tmp.y + y * dec->edged_width;
+    dst.u = dec->tmp.u + (y >> 1) * (dec->edged_width >> 1);
+    dst.v = dec->tmp.v + (y >> 1) * (dec->edged_width >> 1);
+    image_copy(&dst, &src, dec->edged_width, MIN(16, (int)dec->height - y));
+
+    image_postproc_mbrow(&dec->postproc, &dec->tmp, dec->edged_width,
+             dec->mbs, dec->mb_width, dec->mb_height, dec->mb_width,
+             dec->out_rows_flags, bvop, mby);
+    img = &dec->tmp;
+    first = mby - 1;
+    if (mby < (int)dec->mb_height - 1)
+      last = mby - 1;
+  }
+
+  for (r = MAX(first, 0); r <= last; r++)
+    image_output_rows(img, dec->width, dec->height, dec->edged_width,
+           (uint8_t**)dec->out_rows->plane, dec->out_rows->stride, dec->out_rows->csp,
+           dec->interlacing, r << 4, MIN(16, (int)dec->height - (r << 4)));
+}
 
 static void
 decoder_iframe(DECODER * dec,
@@ -758,6 +969,9 @@ decoder_iframe(DECODER * dec,
   const uint32_t mb_height = dec->mb_height;
 
   bound = 0;
+  memset(dec->mb_static, 0, mb_width * mb_height);
+  /* mode, quant, cbp, vectors and the neighbours' predictors, about 16 per macroblock */
+  SRAM_COUNT(SRAM_MBS, 16 * mb_width * mb_height);
 
   for (y = 0; y < mb_height; y++) {
     for (x = 0; x < mb_width; x++) {
@@ -768,8 +982,13 @@ decoder_iframe(DECODER * dec,
       uint32_t cbpy;
       uint32_t cbp;
 
-      while (BitstreamShowBits(bs, 9) == 1)
+      BitstreamCheckTail(bs);
+
+      /* stuffing may run on past the end of the data, each code is checked */
+      while (BitstreamShowBits(bs, 9) == 1) {
         BitstreamSkip(bs, 9);
+        BitstreamCheckTail(bs);
+      }
 
       if (check_resync_marker(bs, 0))
       {
@@ -816,6 +1035,8 @@ decoder_iframe(DECODER * dec,
     }
     if(dec->out_frm)
       output_slice(&dec->cur, dec->edged_width,dec->width,dec->out_frm,0,y,mb_width);
+    if(dec->out_rows)
+      decoder_output_row(dec, y, 0);
   }
 
 }
@@ -955,8 +1176,38 @@ static void get_motion_vector_interlaced(DECODER * dec,
   }
 }
 
-/* for P_VOP set gmc_warp to NULL */
+/* not coded P-VOP macroblocks x..x+count-1 of row y: a plain copy from the
+   reference, a row of pixels at a time for the whole run */
 static void
+decoder_mb_copy_run(DECODER * dec, uint32_t x, uint32_t y, uint32_t count)
+{
+  const uint32_t stride = dec->edged_width;
+  const uint32_t stride2 = stride / 2;
+  const uint32_t offset = (y << 4) * stride + (x << 4);
+  const uint32_t offset2 = (y << 3) * stride2 + (x << 3);
+  uint32_t i;
+
+  start_timer();
+  for (i = 0; i < 16; i++)
+    memcpy(dec->cur.y + offset + i * stride, dec->refn[0].y + offset + i * stride, count << 4);
+  for (i = 0; i < 8; i++) {
+    memcpy(dec->cur.u + offset2 + i * stride2, dec->refn[0].u + offset2 + i * stride2, count << 3);
+    memcpy(dec->cur.v + offset2 + i * stride2, dec->refn[0].v + offset2 + i * stride2, count << 3);
+  }
+  stop_comp_timer();
+}
+
+static __inline void
+decoder_flush_copy_run(DECODER * dec, uint32_t y, uint32_t run_x, uint32_t * run_len)
+{
+  if (*run_len) {
+    decoder_mb_copy_run(dec, run_x, y, *run_len);
+    *run_len = 0;
+  }
+}
+
+/* for P_VOP set gmc_warp to NULL, returns 1 when no macroblock was coded */
+static int
 decoder_pframe(DECODER * dec,
         Bitstream * bs,
         int rounding,
@@ -968,40 +1219,50 @@ decoder_pframe(DECODER * dec,
   uint32_t x, y;
   uint32_t bound;
   int cp_mb, st_mb;
+  uint32_t run_x = 0, run_len = 0; /* not coded macroblocks still to be copied */
+  int all_not_coded = (gmc_warp == NULL);
   const uint32_t mb_width = dec->mb_width;
   const uint32_t mb_height = dec->mb_height;
 
-  if (!dec->is_edged[0]) {
-    start_timer();
-    image_setedges(&dec->refn[0], dec->edged_width, dec->edged_height,
-            dec->width, dec->height, dec->bs_version);
-    dec->is_edged[0] = 1;
-    stop_edges_timer();
-  }
+  decoder_set_padding(dec);
 
   if (gmc_warp) {
     /* accuracy: 0==1/2, 1=1/4, 2=1/8, 3=1/16 */
     generate_GMCparameters( dec->sprite_warping_points,
         dec->sprite_warping_accuracy, gmc_warp,
         dec->width, dec->height, &dec->new_gmc_data);
+    dec->new_gmc_data.pW = dec->pad_width;
+    dec->new_gmc_data.pH = dec->pad_height;
 
     /* image warping is done block-based in decoder_mbgmc(), now */
   }
 
   bound = 0;
+  SRAM_COUNT(SRAM_MBS, 16 * mb_width * mb_height);
 
   for (y = 0; y < mb_height; y++) {
     cp_mb = st_mb = 0;
     for (x = 0; x < mb_width; x++) {
       MACROBLOCK *mb;
 
-      /* skip stuffing */
-      while (BitstreamShowBits(bs, 10) == 1)
+      BitstreamCheckTail(bs);
+
+      /* skip stuffing, it may run on past the end of the data */
+      while (BitstreamShowBits(bs, 10) == 1) {
         BitstreamSkip(bs, 10);
+        BitstreamCheckTail(bs);
+      }
 
       if (check_resync_marker(bs, fcode - 1)) {
+        uint32_t i;
+        decoder_flush_copy_run(dec, y, run_x, &run_len);
         bound = read_video_packet_header(bs, dec, fcode - 1,
           &quant, &fcode, NULL, &intra_dc_threshold);
+        /* macroblocks the packet skips over keep whatever cur had */
+        for (i = y * mb_width + x; i < MIN(bound, mb_width * mb_height); i++)
+          dec->mb_static[i] = 0;
+        if (bound != y * mb_width + x)
+          all_not_coded = 0;
         x = bound % mb_width;
         y = MIN((bound / mb_width), (mb_height-1));
       }
@@ -1014,6 +1275,9 @@ decoder_pframe(DECODER * dec,
         uint32_t intra, acpred_flag = 0;
         int mcsel = 0;    /* mcsel: '0'=local motion, '1'=GMC */
 
+        decoder_flush_copy_run(dec, y, run_x, &run_len);
+        dec->mb_static[y * mb_width + x] = 0;
+        all_not_coded = 0;
         cp_mb++;
         mcbpc = get_mcbpc_inter(bs);
         mb->mode = mcbpc & 7;
@@ -1103,6 +1367,8 @@ decoder_pframe(DECODER * dec,
       } else if (gmc_warp) {  /* a not coded S(GMC)-VOP macroblock */
         mb->mode = MODE_NOT_CODED_GMC;
         mb->quant = quant;
+        decoder_flush_copy_run(dec, y, run_x, &run_len);
+        dec->mb_static[y * mb_width + x] = 0;
         decoder_mbgmc(dec, mb, x, y, fcode, 0x00, bs, rounding);
 
         if(dec->out_frm && cp_mb > 0) {
@@ -1118,8 +1384,17 @@ decoder_pframe(DECODER * dec,
         mb->mvs[0].y = mb->mvs[1].y = mb->mvs[2].y = mb->mvs[3].y = 0;
         mb->field_pred=0; /* (!) */
 
-        decoder_mbinter(dec, mb, x, y, 0, bs, 
-                                rounding, 0, 0);
+        /* a zero vector without residual, copied with the rest of the run
+           unless cur already has the same pixels */
+        if (dec->cur_is_ref && dec->mb_static[y * mb_width + x] >= 2) {
+          decoder_flush_copy_run(dec, y, run_x, &run_len);
+        } else {
+          if (run_len == 0)
+            run_x = x;
+          run_len++;
+        }
+        if (dec->mb_static[y * mb_width + x] < 255)
+          dec->mb_static[y * mb_width + x]++;
 
         if(dec->out_frm && cp_mb > 0) {
           output_slice(&dec->cur, dec->edged_width,dec->width,dec->out_frm,st_mb,y,cp_mb);
@@ -1129,9 +1404,15 @@ decoder_pframe(DECODER * dec,
       }
     }
 
+    decoder_flush_copy_run(dec, y, run_x, &run_len);
+
     if(dec->out_frm && cp_mb > 0)
       output_slice(&dec->cur, dec->edged_width,dec->width,dec->out_frm,st_mb,y,cp_mb);
+    if(dec->out_rows)
+      decoder_output_row(dec, y, 0);
   }
+
+  return all_not_coded;
 }
 
 
@@ -1186,6 +1467,7 @@ decoder_bf_interpolate_mbinter(DECODER * dec,
   int b_uv_dx, b_uv_dy;
   uint8_t *pY_Cur, *pU_Cur, *pV_Cur;
   const uint32_t cbp = pMB->cbp;
+  int i;
 
   pY_Cur = dec->cur.y + (y_pos << 4) * stride + (x_pos << 4);
   pU_Cur = dec->cur.u + (y_pos << 3) * stride2 + (x_pos << 3);
@@ -1219,6 +1501,7 @@ decoder_bf_interpolate_mbinter(DECODER * dec,
     uv_dy = (uv_dy >> 1) + sram_roundtab_79[uv_dy & 0x3];
     b_uv_dx = (b_uv_dx >> 1) + sram_roundtab_79[b_uv_dx & 0x3];
     b_uv_dy = (b_uv_dy >> 1) + sram_roundtab_79[b_uv_dy & 0x3];
+    SRAM_COUNT(SRAM_ROUNDTAB_79, 4);
 
   } else {
 	  if (dec->quarterpel) { /* for qpel the /2 shall be done before summation. We've done it right in the encoder in the past. */
@@ -1251,79 +1534,43 @@ decoder_bf_interpolate_mbinter(DECODER * dec,
     uv_dy = (uv_dy >> 3) + sram_roundtab_76[uv_dy & 0xf];
     b_uv_dx = (b_uv_dx >> 3) + sram_roundtab_76[b_uv_dx & 0xf];
     b_uv_dy = (b_uv_dy >> 3) + sram_roundtab_76[b_uv_dy & 0xf];
+    SRAM_COUNT(SRAM_ROUNDTAB_76, 4);
   }
 
   start_timer();
-  if(dec->quarterpel) {
-    if(!direct) {
-      interpolate16x16_quarterpel(dec->cur.y, forward.y, dec->qtmp.y, dec->qtmp.y + 64,
-                    dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
-                    pMB->mvs[0].x, pMB->mvs[0].y, stride, 0);
-    } else {
-      interpolate8x8_quarterpel(dec->cur.y, forward.y, dec->qtmp.y, dec->qtmp.y + 64,
-                    dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
-                    pMB->mvs[0].x, pMB->mvs[0].y, stride, 0);
-      interpolate8x8_quarterpel(dec->cur.y, forward.y, dec->qtmp.y, dec->qtmp.y + 64,
-                    dec->qtmp.y + 128, 16*x_pos + 8, 16*y_pos,
-                    pMB->mvs[1].x, pMB->mvs[1].y, stride, 0);
-      interpolate8x8_quarterpel(dec->cur.y, forward.y, dec->qtmp.y, dec->qtmp.y + 64,
-                    dec->qtmp.y + 128, 16*x_pos, 16*y_pos + 8,
-                    pMB->mvs[2].x, pMB->mvs[2].y, stride, 0);
-      interpolate8x8_quarterpel(dec->cur.y, forward.y, dec->qtmp.y, dec->qtmp.y + 64,
-                    dec->qtmp.y + 128, 16*x_pos + 8, 16*y_pos + 8,
-                    pMB->mvs[3].x, pMB->mvs[3].y, stride, 0);
-    }
+  if(dec->quarterpel && !direct) {
+    decoder_mc(dec, pY_Cur, forward.y, stride, 0, 16*x_pos, 16*y_pos, 1,
+               pMB->mvs[0].x, pMB->mvs[0].y, 16, 16, 0, MC_QPEL);
   } else {
-    interpolate8x8_switch(dec->cur.y, forward.y, 16 * x_pos, 16 * y_pos,
-              pMB->mvs[0].x, pMB->mvs[0].y, stride, 0);
-    interpolate8x8_switch(dec->cur.y, forward.y, 16 * x_pos + 8, 16 * y_pos,
-              pMB->mvs[1].x, pMB->mvs[1].y, stride, 0);
-    interpolate8x8_switch(dec->cur.y, forward.y, 16 * x_pos, 16 * y_pos + 8,
-              pMB->mvs[2].x, pMB->mvs[2].y, stride, 0);
-    interpolate8x8_switch(dec->cur.y, forward.y, 16 * x_pos + 8, 16 * y_pos + 8,
-              pMB->mvs[3].x, pMB->mvs[3].y, stride, 0);
+    for (i = 0; i < 4; i++) {
+      const int bx = 16*x_pos + 8*(i & 1), by = 16*y_pos + 8*(i >> 1);
+      decoder_mc(dec, dec->cur.y + by*stride + bx, forward.y, stride, 0, bx, by, 1,
+                 pMB->mvs[i].x, pMB->mvs[i].y, 8, 8, 0, dec->quarterpel ? MC_QPEL : 0);
+    }
   }
 
-  interpolate8x8_switch(dec->cur.u, forward.u, 8 * x_pos, 8 * y_pos, uv_dx,
-            uv_dy, stride2, 0);
-  interpolate8x8_switch(dec->cur.v, forward.v, 8 * x_pos, 8 * y_pos, uv_dx,
-            uv_dy, stride2, 0);
+  decoder_mc(dec, pU_Cur, forward.u, stride2, 1, 8 * x_pos, 8 * y_pos, 1,
+             uv_dx, uv_dy, 8, 8, 0, 0);
+  decoder_mc(dec, pV_Cur, forward.v, stride2, 1, 8 * x_pos, 8 * y_pos, 1,
+             uv_dx, uv_dy, 8, 8, 0, 0);
 
 
-  if(dec->quarterpel) {
-    if(!direct) {
-      interpolate16x16_add_quarterpel(dec->cur.y, backward.y, dec->qtmp.y, dec->qtmp.y + 64,
-          dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
-          pMB->b_mvs[0].x, pMB->b_mvs[0].y, stride, 0);
-    } else {
-      interpolate8x8_add_quarterpel(dec->cur.y, backward.y, dec->qtmp.y, dec->qtmp.y + 64,
-          dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
-          pMB->b_mvs[0].x, pMB->b_mvs[0].y, stride, 0);
-      interpolate8x8_add_quarterpel(dec->cur.y, backward.y, dec->qtmp.y, dec->qtmp.y + 64,
-          dec->qtmp.y + 128, 16*x_pos + 8, 16*y_pos,
-          pMB->b_mvs[1].x, pMB->b_mvs[1].y, stride, 0);
-      interpolate8x8_add_quarterpel(dec->cur.y, backward.y, dec->qtmp.y, dec->qtmp.y + 64,
-          dec->qtmp.y + 128, 16*x_pos, 16*y_pos + 8,
-          pMB->b_mvs[2].x, pMB->b_mvs[2].y, stride, 0);
-      interpolate8x8_add_quarterpel(dec->cur.y, backward.y, dec->qtmp.y, dec->qtmp.y + 64,
-          dec->qtmp.y + 128, 16*x_pos + 8, 16*y_pos + 8,
-          pMB->b_mvs[3].x, pMB->b_mvs[3].y, stride, 0);
-    }
+  if(dec->quarterpel && !direct) {
+    decoder_mc(dec, pY_Cur, backward.y, stride, 0, 16*x_pos, 16*y_pos, 1,
+               pMB->b_mvs[0].x, pMB->b_mvs[0].y, 16, 16, 0, MC_QPEL | MC_ADD);
   } else {
-    interpolate8x8_add_switch(dec->cur.y, backward.y, 16 * x_pos, 16 * y_pos,
-        pMB->b_mvs[0].x, pMB->b_mvs[0].y, stride, 0);
-    interpolate8x8_add_switch(dec->cur.y, backward.y, 16 * x_pos + 8,
-        16 * y_pos, pMB->b_mvs[1].x, pMB->b_mvs[1].y, stride, 0);
-    interpolate8x8_add_switch(dec->cur.y, backward.y, 16 * x_pos,
-        16 * y_pos + 8, pMB->b_mvs[2].x, pMB->b_mvs[2].y, stride, 0);
-    interpolate8x8_add_switch(dec->cur.y, backward.y, 16 * x_pos + 8,
-        16 * y_pos + 8, pMB->b_mvs[3].x, pMB->b_mvs[3].y, stride, 0);
+    for (i = 0; i < 4; i++) {
+      const int bx = 16*x_pos + 8*(i & 1), by = 16*y_pos + 8*(i >> 1);
+      decoder_mc(dec, dec->cur.y + by*stride + bx, backward.y, stride, 0, bx, by, 1,
+                 pMB->b_mvs[i].x, pMB->b_mvs[i].y, 8, 8, 0,
+                 dec->quarterpel ? MC_QPEL | MC_ADD : MC_ADD);
+    }
   }
 
-  interpolate8x8_add_switch(dec->cur.u, backward.u, 8 * x_pos, 8 * y_pos,
-      b_uv_dx, b_uv_dy, stride2, 0);
-  interpolate8x8_add_switch(dec->cur.v, backward.v, 8 * x_pos, 8 * y_pos,
-      b_uv_dx, b_uv_dy, stride2, 0);
+  decoder_mc(dec, pU_Cur, backward.u, stride2, 1, 8 * x_pos, 8 * y_pos, 1,
+             b_uv_dx, b_uv_dy, 8, 8, 0, MC_ADD);
+  decoder_mc(dec, pV_Cur, backward.v, stride2, 1, 8 * x_pos, 8 * y_pos, 1,
+             b_uv_dx, b_uv_dy, 8, 8, 0, MC_ADD);
 
   stop_comp_timer();
 
@@ -1375,7 +1622,8 @@ decoder_bframe(DECODER * dec,
         Bitstream * bs,
         int quant,
         int fcode_forward,
-        int fcode_backward)
+        int fcode_backward,
+        const int parse_only)
 {
   uint32_t x, y;
   VECTOR mv;
@@ -1383,23 +1631,13 @@ decoder_bframe(DECODER * dec,
   int i;
   int resync_len;
 
-  if (!dec->is_edged[0]) {
-    start_timer();
-    image_setedges(&dec->refn[0], dec->edged_width, dec->edged_height,
-            dec->width, dec->height, dec->bs_version);
-    dec->is_edged[0] = 1;
-    stop_edges_timer();
-  }
-
-  if (!dec->is_edged[1]) {
-    start_timer();
-    image_setedges(&dec->refn[1], dec->edged_width, dec->edged_height,
-            dec->width, dec->height, dec->bs_version);
-    dec->is_edged[1] = 1;
-    stop_edges_timer();
-  }
+  /* parse_only: the b-vop is dropped, read the bitstream but skip MC and iDCT.
+     b-vops are never referenced, so the reference frames stay valid */
+  decoder_set_padding(dec);
 
   resync_len = get_resync_len_b(fcode_backward, fcode_forward);
+  /* the B-VOP's macroblocks and the co-located ones of the last P-VOP */
+  SRAM_COUNT(SRAM_MBS, 2 * 16 * dec->mb_width * dec->mb_height);
   for (y = 0; y < dec->mb_height; y++) {
     /* Initialize Pred Motion Vector */
     dec->p_fmv = dec->p_bmv = zeromv;
@@ -1408,6 +1646,8 @@ decoder_bframe(DECODER * dec,
       MACROBLOCK *last_mb = &dec->last_mbs[y * dec->mb_width + x];
       int intra_dc_threshold; /* fake variable */
 
+      BitstreamCheckTail(bs);
+
       mv =
       mb->b_mvs[0] = mb->b_mvs[1] = mb->b_mvs[2] = mb->b_mvs[3] =
       mb->mvs[0] = mb->mvs[1] = mb->mvs[2] = mb->mvs[3] = zeromv;
@@ -1422,7 +1662,8 @@ decoder_bframe(DECODER * dec,
       if (last_mb->mode == MODE_NOT_CODED) {
         mb->cbp = 0;
         mb->mode = MODE_FORWARD;
-        decoder_mbinter(dec, mb, x, y, mb->cbp, bs, 0, 1, 1);
+        if (!parse_only)
+          decoder_mbinter(dec, mb, x, y, mb->cbp, bs, 0, 1, 1);
         continue;
       }
 
@@ -1483,6 +1724,32 @@ decoder_bframe(DECODER * dec,
         mb->cbp = 0;
       }
 
+      if (parse_only) {
+        /* motion vectors still have to be read to find the residual */
+        switch (mb->mode) {
+        case MODE_DIRECT:
+          get_b_motion_vector(bs, &mv, 1, zeromv, dec, x, y);
+          break;
+        case MODE_INTERPOLATE:
+          get_b_motion_vector(bs, &mb->mvs[0], fcode_forward, dec->p_fmv, dec, x, y);
+          dec->p_fmv = mb->mvs[0];
+          get_b_motion_vector(bs, &mb->b_mvs[0], fcode_backward, dec->p_bmv, dec, x, y);
+          dec->p_bmv = mb->b_mvs[0];
+          break;
+        case MODE_BACKWARD:
+          get_b_motion_vector(bs, &mb->mvs[0], fcode_backward, dec->p_bmv, dec, x, y);
+          dec->p_bmv = mb->mvs[0];
+          break;
+        case MODE_FORWARD:
+          get_b_motion_vector(bs, &mb->mvs[0], fcode_forward, dec->p_fmv, dec, x, y);
+          dec->p_fmv = mb->mvs[0];
+          break;
+        }
+        if (mb->cbp)
+          decoder_mb_skip_residual(dec, mb->cbp, bs, mb);
+        continue;
+      }
+
       switch (mb->mode) {
       case MODE_DIRECT:
         get_b_motion_vector(bs, &mv, 1, zeromv, dec, x, y);
@@ -1533,6 +1800,8 @@ decoder_bframe(DECODER * dec,
         DPRINTF(XVID_DEBUG_ERROR,"Not supported B-frame mb_type = %i\n", mb->mode);
       }
     } /* End of for */
+    if (dec->out_rows)
+      decoder_output_row(dec, y, 1);
   }
 }
 
@@ -1542,12 +1811,22 @@ static void decoder_output(DECODER * dec, IMAGE * img, MACROBLOCK * mbs,
           int coding_type, int quant)
 {
   const int brightness = XVID_VERSION_MINOR(frame->version) >= 1 ? frame->brightness : 0;
-
+  /* converted row by row while it was decoded */
+  const int rows_done = (dec->out_rows != NULL && img == &dec->cur);
+  /* the caller still has this picture from the previous call */
+  const int repeat = (dec->last_output != NULL && img->y == dec->last_output);
+  const int skip = rows_done || (repeat && (frame->general & XVID_DEC_REPEAT));
+
+  dec->out_rows = NULL;
+  dec->last_output = (frame->general & XVID_DEC_PREROLL) ? NULL : img->y;
   if (dec->cartoon_mode)
     frame->general &= ~XVID_FILMEFFECT;
 
-  if ((frame->general & (XVID_DEBLOCKY|XVID_DEBLOCKUV|XVID_FILMEFFECT) || brightness!=0)
-    && mbs != NULL) /* post process */
+  if ((frame->general & XVID_DEC_PREROLL) || skip) {
+    /* picture won't be shown or is already converted, skip post processing and colorspace conversion */
+  }
+  else if ((frame->general & (XVID_DEBLOCKY|XVID_DEBLOCKUV|XVID_FILMEFFECT) || brightness!=0)
+    && mbs != NULL && decoder_alloc_tmp(dec) == 0) /* post process */
   {
     /* note: image is stored to tmp */
     image_copy(&dec->tmp, img, dec->edged_width, dec->height);
@@ -1557,7 +1836,8 @@ static void decoder_output(DECODER * dec, IMAGE * img, MACROBLOCK * mbs,
     img = &dec->tmp;
   }
 
-  if ((frame->output.plane[0] != NULL) && (frame->output.stride[0] >= dec->width)) {
+  if (!(frame->general & XVID_DEC_PREROLL) && !skip &&
+    (frame->output.plane[0] != NULL) && (frame->output.stride[0] >= dec->width)) {
     image_output(img, dec->width, dec->height,
            dec->edged_width, (uint8_t**)frame->output.plane, frame->output.stride,
            frame->output.csp, dec->interlacing);
@@ -1565,12 +1845,15 @@ static void decoder_output(DECODER * dec, IMAGE * img, MACROBLOCK * mbs,
 
   if (stats) {
     stats->type = coding2type(coding_type);
+    if (repeat)
+      stats->data.vop.general |= XVID_VOP_REPEAT;
     stats->data.vop.time_base = (int)dec->time_base;
     stats->data.vop.time_increment = 0; /* XXX: todo */
     stats->data.vop.qscale_stride = dec->mb_width;
     stats->data.vop.qscale = dec->qscale;
     if (stats->data.vop.qscale != NULL && mbs != NULL) {
       unsigned int i;
+      SRAM_COUNT(SRAM_QSCALE, dec->mb_width*dec->mb_height);
       for (i = 0; i < dec->mb_width*dec->mb_height; i++)
         stats->data.vop.qscale[i] = mbs[i].quant;
     } else
@@ -1578,6 +1861,53 @@ static void decoder_output(DECODER * dec, IMAGE * img, MACROBLOCK * mbs,
   }
 }
 
+/* after an I/P/S-VOP: refn[1] <- refn[0], refn[0] <- cur, cur <- old refn[1],
+   or without refn[1] just cur <-> refn[0] */
+static void
+decoder_rotate_refs(DECODER * dec)
+{
+  if (dec->refn[1].y == NULL) {
+    /* cur gets the VOP before refn[0], even closer than the one before refn[1] */
+    image_swap(&dec->cur, &dec->refn[0]);
+    dec->cur_is_ref = 1;
+  } else if (dec->refn_shared) {
+    /* refn[1] already is refn[0], the spare buffer is free for the next VOP */
+    dec->refn[0] = dec->cur;
+    dec->cur = dec->spare;
+    image_null(&dec->spare);
+    dec->refn_shared = 0;
+    dec->cur_is_ref = 0;
+  } else {
+    image_swap(&dec->refn[0], &dec->refn[1]);
+    image_swap(&dec->cur, &dec->refn[0]);
+    dec->cur_is_ref = 1;
+  }
+}
+
+/* after a VOP that is a copy of refn[0]: instead of copying it refn[1]
+   becomes a second reference to refn[0]'s planes */
+static void
+decoder_share_refs(DECODER * dec)
+{
+  if (dec->refn[1].y == NULL) {
+    /* refn[0] stays, cur may have some of its macroblocks copied in by now */
+    dec->cur_is_ref = 0;
+    return;
+  }
+  if (dec->refn_shared) {
+    /* both references are the same picture already, cur holds an older one */
+    dec->cur_is_ref = 0;
+    return;
+  }
+  /* cur gets refn[1]'s picture, the VOP before the new refn[1] like after
+     decoder_rotate_refs() */
+  dec->spare = dec->cur;
+  dec->cur = dec->refn[1];
+  dec->refn[1] = dec->refn[0];
+  dec->refn_shared = 1;
+  dec->cur_is_ref = 1;
+}
+
 int
 decoder_decode(DECODER * dec,
         xvid_dec_frame_t * frame, xvid_dec_stats_t * stats)
@@ -1591,6 +1921,7 @@ decoder_decode(DECODER * dec,
   uint32_t intra_dc_threshold = 0;
   WARPPOINTS gmc_warp;
   int coding_type = -1;
+  int not_coded = 0;
   int success, output, seen_something;
 
   if (XVID_VERSION_MAJOR(frame->version) != 1 || (stats && XVID_VERSION_MAJOR(stats->version) != 1))  /* v1.x.x */
@@ -1600,9 +1931,12 @@ decoder_decode(DECODER * dec,
   memset((void *)&gmc_warp, 0, sizeof(WARPPOINTS));
 
   dec->low_delay_default = (frame->general & XVID_LOWDELAY);
-  if ((frame->general & XVID_DISCONTINUITY))
+  if ((frame->general & XVID_DISCONTINUITY)) {
     dec->frames = 0;
-  dec->out_frm = (frame->output.csp == XVID_CSP_SLICE) ? &frame->output : NULL;
+    dec->last_output = NULL;
+  }
+  dec->out_frm = (frame->output.csp == XVID_CSP_SLICE && !(frame->general & XVID_DEC_PREROLL)) ? &frame->output : NULL;
+  dec->out_rows = NULL;
 
   if(frame->length<0) {  /* decoder flush */
     int ret;
@@ -1663,6 +1997,8 @@ repeat:
 
     if (coding_type == -3)
       if (decoder_resize(dec)) return XVID_ERR_MEMORY;
+    if (!dec->low_delay)
+      if (decoder_alloc_bvop_refs(dec)) return XVID_ERR_MEMORY;
 
     if(stats) {
       stats->type = XVID_TYPE_VOL;
@@ -1691,6 +2027,10 @@ repeat:
 
   dec->p_bmv.x = dec->p_bmv.y = dec->p_fmv.x = dec->p_fmv.y = 0;  /* init pred vector to 0 */
 
+  /* whatever is decoded into cur is a new picture */
+  if (dec->cur.y == dec->last_output)
+    dec->last_output = NULL;
+
   /* packed_mode: special-N_VOP treament */
   if (dec->packed_mode && coding_type == N_VOP) {
     if (dec->low_delay_default && dec->frames > 0) {
@@ -1699,30 +2039,41 @@ repeat:
     }
     /* ignore otherwise */
   } else if (coding_type != B_VOP) {
+    /* with low_delay the picture is output right after decoding */
+    if (dec->low_delay && !(dec->low_delay_default && dec->packed_mode) && coding_type != N_VOP)
+      dec->out_rows = decoder_rows_output(dec, frame);
+
     switch(coding_type) {
     case I_VOP :
       decoder_iframe(dec, &bs, quant, intra_dc_threshold);
       break;
     case P_VOP :
-      decoder_pframe(dec, &bs, rounding, quant,
+      not_coded = decoder_pframe(dec, &bs, rounding, quant,
                         fcode_forward, intra_dc_threshold, NULL);
       break;
     case S_VOP :
       decoder_pframe(dec, &bs, rounding, quant,
                         fcode_forward, intra_dc_threshold, &gmc_warp);
       break;
-    case N_VOP :
+    case N_VOP : {
+      uint32_t i;
       /* XXX: not_coded vops are not used for forward prediction */
       /* we should not swap(last_mbs,mbs) */
-      image_copy(&dec->cur, &dec->refn[0], dec->edged_width, dec->height);
       SWAP(MACROBLOCK *, dec->mbs, dec->last_mbs); /* it will be swapped back */
+      for (i = 0; i < dec->mb_width * dec->mb_height; i++) {
+        if (dec->mb_static[i] < 255)
+          dec->mb_static[i]++;
+      }
+      not_coded = 1;
       break;
     }
+    }
 
     /* note: for packed_mode, output is performed when the special-N_VOP is decoded */
     if (!(dec->low_delay_default && dec->packed_mode)) {
       if(dec->low_delay) {
-        decoder_output(dec, &dec->cur, dec->mbs, frame, stats, coding_type, quant);
+        /* refn[0] is the same picture and maybe still with the caller */
+        decoder_output(dec, not_coded ? &dec->refn[0] : &dec->cur, dec->mbs, frame, stats, coding_type, quant);
         output = 1;
       } else if (dec->frames > 0) { /* is the reference frame valid? */
         /* output the reference frame */
@@ -1731,10 +2082,10 @@ repeat:
       }
     }
     
-    image_swap(&dec->refn[0], &dec->refn[1]);
-    dec->is_edged[1] = dec->is_edged[0];
-    image_swap(&dec->cur, &dec->refn[0]);
-    dec->is_edged[0] = 0;
+    if (not_coded)
+      decoder_share_refs(dec);
+    else
+      decoder_rotate_refs(dec);
     SWAP(MACROBLOCK *, dec->mbs, dec->last_mbs);
     dec->last_coding_type = coding_type;
 
@@ -1747,6 +2098,13 @@ repeat:
       DPRINTF(XVID_DEBUG_ERROR, "warning: bvop found in low_delay==1 stream\n");
       dec->low_delay = 0;
     }
+    if (decoder_alloc_bvop_refs(dec)) {
+      emms();
+      stop_global_timer();
+      return XVID_ERR_MEMORY;
+    }
+
+    dec->cur_is_ref = 0;
 
     if (dec->frames < 2) {
       /* attemping to decode a bvop without atleast 2 reference frames */
@@ -1760,7 +2118,14 @@ repeat:
             "broken b-frame, tpp=%i tbp=%i", dec->time_pp, dec->time_bp);
       if (stats) stats->type = XVID_TYPE_NOTHING;
     } else {
-      decoder_bframe(dec, &bs, quant, fcode_forward, fcode_backward);
+      if (frame->general & XVID_DEC_DROP) {
+        /* nothing to show, only parse */
+        frame->general |= XVID_DEC_PREROLL;
+        decoder_bframe(dec, &bs, quant, fcode_forward, fcode_backward, 1);
+      } else {
+        dec->out_rows = decoder_rows_output(dec, frame);
+        decoder_bframe(dec, &bs, quant, fcode_forward, fcode_backward, 0);
+      }
       decoder_output(dec, &dec->cur, dec->mbs, frame, stats, coding_type, quant);
     }
 
@@ -1796,6 +2161,9 @@ done :
       decoder_output(dec, &dec->refn[0], dec->last_mbs, frame, stats, dec->last_coding_type, quant);
     } else {
       image_clear(&dec->cur, dec->width, dec->height, dec->edged_width, 0, 128, 128);
+      dec->cur_is_ref = 0;
+      if (dec->cur.y == dec->last_output)
+        dec->last_output = NULL;
       decoder_output(dec, &dec->cur, NULL, frame, stats, P_VOP, quant);
       if (stats) stats->type = XVID_TYPE_NOTHING;
     }
@@ -113,14 +113,19 @@ typedef struct
 	int fixed_dimensions;
 	uint32_t width;
 	uint32_t height;
+	/* plane stride and rows, the planes have no EDGE_SIZE border: motion
+	 * vectors reaching out of the pad_width x pad_height picture read
+	 * through edge_block, see decoder_mc() */
 	uint32_t edged_width;
 	uint32_t edged_height;
+	uint32_t pad_width;
+	uint32_t pad_height;
+	uint8_t *edge_block;
 
 	IMAGE cur;
 	IMAGE refn[2];				/* 0   -- last I or P VOP */
-								/* 1   -- first I or P */
-	IMAGE tmp;		/* bframe interpolation, and post processing tmp buffer */
-	IMAGE qtmp;		/* quarter pel tmp buffer */
+								/* 1   -- first I or P, no planes until B-VOPs may follow */
+	IMAGE tmp;		/* post processing tmp buffer, no planes until asked for */
 
 	/* postprocessing */
 	XVID_POSTPROC postproc;
@@ -153,16 +158,32 @@ typedef struct
 
 	/* for GMC: central place for all parameters */
 
-	IMAGE gmc;		/* gmc tmp buffer, remove for blockbased compensation */
 	GMC_DATA gmc_data;
 	NEW_GMC_DATA new_gmc_data;
 
 	xvid_image_t* out_frm;                /* This is used for slice rendering */
+	xvid_image_t* out_rows;               /* packed output converted per macroblock row while decoding, see decoder_rows_output() */
+	int out_rows_flags;                   /* deblocking done per row before the conversion */
 
 	int * qscale;				/* quantization table for decoder's stats */
 
-	/* Tells if the reference image is edged or not */
-	int is_edged[2];
+	/* not coded P-VOP macroblocks: mb_static counts the reference VOPs in a row
+	 * each macroblock was copied into unchanged (saturating). cur holds the VOP
+	 * before refn[1] (before refn[0] without refn[1]) until a B-VOP is decoded
+	 * into it, so a macroblock with a count of 2 or more is already there and
+	 * needs no copy */
+	uint8_t *mb_static;
+	int cur_is_ref;
+
+	/* a VOP without coded macroblocks (N-VOP or all not coded P-VOP) gets no
+	 * buffer of its own: refn[1] shares refn[0]'s planes and the buffer it
+	 * held waits in spare until the next coded VOP rotates the references */
+	IMAGE spare;
+	int refn_shared;
+
+	/* luma plane of the picture output last, NULL when nothing was shown.
+	 * outputting the same buffer again, unchanged, is reported as a repeat */
+	const uint8_t *last_output;
 
 	int num_threads;
 
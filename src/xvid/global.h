@@ -142,6 +142,9 @@ typedef struct _NEW_GMC_DATA
 	/* sprite size * 16 */
 	int sW, sH;
 
+	/* size of the reference planes, reads outside repeat their edge pixels */
+	int pW, pH;
+
 	/* gradient, calculated from warp points */
 	int dU[2], dV[2], Uo, Vo, Uco, Vco;
 
@@ -166,8 +169,16 @@ IMAGE;
 
 typedef struct
 {
-	uint32_t bufa;
-	uint32_t bufb;
+	/* reader, the next bit is the msb of cache */
+	uint64_t cache;
+	uint32_t bits;				/* valid bits in cache, at least 32 between calls */
+	const uint32_t *rdtail;		/* next word to load into cache */
+	const uint32_t *rdbuf;		/* buffer rdtail points into */
+	const uint8_t *rdend;		/* end of the data in rdbuf */
+	const uint8_t *rdguard;		/* BitstreamCheckTail() bounces the tail once rdtail passes this */
+	int32_t rdbase;				/* stream position of rdbuf in bits */
+
+	/* writer */
 	uint32_t buf;
 	uint32_t pos;
 	uint32_t *tail;
@@ -1,6 +1,7 @@
 #include "../../global.h"
 #include "../colorspace.h"
 #include "../../utils/mem_align.h"
+#include "../../utils/sram_plan.h"
 
 #if defined(__GNUC__) || defined(__clang__)
   typedef uint32_t u32_alias __attribute__((__may_alias__));
@@ -29,7 +30,7 @@ enum { CLAMP_CENTER = 1024, CLAMP_SIZE = 2048 };
 
 void init_yv12_to_rgb565_tables(void) {
     // allocate tables in sram: 5 * 256 int32_t values + 2048 byte clamp table + 3 * 256 uint16_t shift tables
-    uint8_t* sramTable = xvid_malloc_sram(5 * 256 * sizeof(int32_t) + CLAMP_SIZE, CACHE_LINE);
+    uint8_t* sramTable = xvid_malloc_planned(SRAM_RGB565, 5 * 256 * sizeof(int32_t) + CLAMP_SIZE, CACHE_LINE);
     g_Ytab = (int32_t*)sramTable;
     g_UtoB = (g_Ytab + 256);
     g_UtoG = (g_UtoB + 256);
@@ -119,6 +120,9 @@ void yv12_to_rgb565_concept(
     // Center clamp pointer so clamp_centered[val] works with val in [-1024..1023]
     const uint8_t* clamp_centered = g_Clamp + CLAMP_CENTER;
 
+    // per pixel one Y and three clamp lookups, four chroma lookups per 2x2 block
+    SRAM_COUNT(SRAM_RGB565, 5 * width * height);
+
     // Output setup (word-based stores)
     int dst_stride_words = x_stride >> 2;
     u32_alias* dst_row = (u32_alias*)x_ptr;
@@ -215,4 +219,99 @@ void yv12_to_rgb565_concept(
         v_row  += uv_stride;
         dst_row += 2 * dst_stride_words;
     }
-}
\ No newline at end of file
+}
+// Tile edge in source pixels. A 16x16 tile reads 16 Y lines + 8 U/V half lines and
+// writes 16 output rows of 32 bytes (one cache line each), so both sides of the
+// transpose stay resident in the 16KB D-cache while the tile is converted.
+enum { ROT_TILE = 16 };
+
+/*
+ * Same conversion as yv12_to_rgb565_concept, but the output is the picture rotated
+ * 90 degrees clockwise: source pixel (x, y) lands in output row x, column height-1-y.
+ * x_ptr is height pixels wide and width rows high, x_stride is the stride of an output row.
+ * width and height must be even and x_ptr/x_stride word aligned.
+ */
+__attribute__((hot))
+void yv12_to_rgb565_rot90_concept(
+    uint8_t *restrict x_ptr,
+    int x_stride,
+    uint8_t *restrict y_src,
+    uint8_t *restrict u_src,
+    uint8_t *restrict v_src,
+    int y_stride,
+    int uv_stride,
+    int width,
+    int height,
+    int vflip
+) {
+    const int32_t* Ytab = g_Ytab;
+    const int32_t* VtoR = g_VtoR;
+    const int32_t* VtoG = g_VtoG;
+    const int32_t* UtoB = g_UtoB;
+    const int32_t* UtoG = g_UtoG;
+    const uint8_t* clamp_centered = g_Clamp + CLAMP_CENTER;
+
+    SRAM_COUNT(SRAM_RGB565, 5 * width * height);
+
+    if (vflip) {
+        // flipping the source is the same as reading it bottom up
+        y_src += (height - 1) * y_stride;
+        u_src += (height / 2 - 1) * uv_stride;
+        v_src += (height / 2 - 1) * uv_stride;
+        y_stride = -y_stride;
+        uv_stride = -uv_stride;
+    }
+
+    const int dst_stride_words = x_stride >> 2;
+
+    for (int ty = 0; ty < height; ty += ROT_TILE) {
+        const int th = (height - ty < ROT_TILE) ? (height - ty) : ROT_TILE;
+
+        // source rows ty and ty+1 end up in the output word holding columns height-2-ty and height-1-ty
+        u32_alias* dst_tile = (u32_alias*)(x_ptr + (height - 2 - ty) * 2);
+
+        for (int tx = 0; tx < width; tx += ROT_TILE) {
+            const int tw = (width - tx < ROT_TILE) ? (width - tx) : ROT_TILE;
+
+            const uint8_t* y_tile = y_src + ty * y_stride + tx;
+            const uint8_t* u_tile = u_src + (ty / 2) * uv_stride + tx / 2;
+            const uint8_t* v_tile = v_src + (ty / 2) * uv_stride + tx / 2;
+            u32_alias* dst_col = dst_tile + tx * dst_stride_words;
+
+            // one source column pair at a time, each is a run of consecutive words in two output rows
+            for (int x = 0; x < tw; x += 2) {
+                const uint8_t* y0 = y_tile + x;
+                const uint8_t* u = u_tile + x / 2;
+                const uint8_t* v = v_tile + x / 2;
+                u32_alias* dst0 = dst_col + x * dst_stride_words;
+                u32_alias* dst1 = dst0 + dst_stride_words;
+
+                for (int y = 0; y < th; y += 2) {
+                    uint8_t u0 = *u;
+                    uint8_t v0 = *v;
+                    int32_t vr   = VtoR[v0];
+                    int32_t ub   = UtoB[u0];
+                    int32_t ugvg = UtoG[u0] + VtoG[v0];
+
+                    uint16_t y0_2 = *(const u16_alias*)y0;
+                    uint16_t y1_2 = *(const u16_alias*)(y0 + y_stride);
+
+                    uint16_t p00 = yuv_to_rgb565_pixel((uint8_t)y0_2,        vr, ugvg, ub, Ytab, clamp_centered);
+                    uint16_t p01 = yuv_to_rgb565_pixel((uint8_t)(y0_2 >> 8), vr, ugvg, ub, Ytab, clamp_centered);
+                    uint16_t p10 = yuv_to_rgb565_pixel((uint8_t)y1_2,        vr, ugvg, ub, Ytab, clamp_centered);
+                    uint16_t p11 = yuv_to_rgb565_pixel((uint8_t)(y1_2 >> 8), vr, ugvg, ub, Ytab, clamp_centered);
+
+                    // the lower source row is further left in the output
+                    *dst0 = (uint32_t)p10 | ((uint32_t)p00 << 16);
+                    *dst1 = (uint32_t)p11 | ((uint32_t)p01 << 16);
+
+                    y0 += 2 * y_stride;
+                    u += uv_stride;
+                    v += uv_stride;
+                    dst0--;
+                    dst1--;
+                }
+            }
+        }
+    }
+}
@@ -176,5 +176,18 @@ void yv12_to_rgb565_concept(
     int height,
     int vflip
 );
+/* rotated 90 degrees clockwise, x_ptr is height pixels wide and width rows high */
+void yv12_to_rgb565_rot90_concept(
+    uint8_t *RESTRICT x_ptr,
+    int x_stride,
+    uint8_t *RESTRICT y_src,
+    uint8_t *RESTRICT u_src,
+    uint8_t *RESTRICT v_src,
+    int y_stride,
+    int uv_stride,
+    int width,
+    int height,
+    int vflip
+);
 
 #endif							/* _COLORSPACE_H_ */
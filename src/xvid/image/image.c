@@ -42,13 +42,15 @@
 #define EDGE_SIZE2  (EDGE_SIZE/2)
 
 
-int32_t
-image_create(IMAGE * image,
-			 uint32_t edged_width,
-			 uint32_t edged_height)
+static int32_t
+image_alloc(IMAGE * image,
+			uint32_t edged_width,
+			uint32_t edged_height,
+			uint32_t edge_size)
 {
 	const uint32_t edged_width2 = edged_width / 2;
 	const uint32_t edged_height2 = edged_height / 2;
+	const uint32_t edge_size2 = edge_size / 2;
 
 	image->y =
 		xvid_malloc(edged_width * (edged_height + 1) + SAFETY, CACHE_LINE);
@@ -75,36 +77,69 @@ image_create(IMAGE * image,
 	}
 	memset(image->v, 0, edged_width2 * edged_height2 + SAFETY);
 
-	image->y += EDGE_SIZE * edged_width + EDGE_SIZE;
-	image->u += EDGE_SIZE2 * edged_width2 + EDGE_SIZE2;
-	image->v += EDGE_SIZE2 * edged_width2 + EDGE_SIZE2;
+	image->y += edge_size * edged_width + edge_size;
+	image->u += edge_size2 * edged_width2 + edge_size2;
+	image->v += edge_size2 * edged_width2 + edge_size2;
 
 	return 0;
 }
 
-
-
-void
-image_destroy(IMAGE * image,
-			  uint32_t edged_width,
-			  uint32_t edged_height)
+static void
+image_free(IMAGE * image,
+		   uint32_t edged_width,
+		   uint32_t edge_size)
 {
 	const uint32_t edged_width2 = edged_width / 2;
+	const uint32_t edge_size2 = edge_size / 2;
 
 	if (image->y) {
-		xvid_free(image->y - (EDGE_SIZE * edged_width + EDGE_SIZE));
+		xvid_free(image->y - (edge_size * edged_width + edge_size));
 		image->y = NULL;
 	}
 	if (image->u) {
-		xvid_free(image->u - (EDGE_SIZE2 * edged_width2 + EDGE_SIZE2));
+		xvid_free(image->u - (edge_size2 * edged_width2 + edge_size2));
 		image->u = NULL;
 	}
 	if (image->v) {
-		xvid_free(image->v - (EDGE_SIZE2 * edged_width2 + EDGE_SIZE2));
+		xvid_free(image->v - (edge_size2 * edged_width2 + edge_size2));
 		image->v = NULL;
 	}
 }
 
+int32_t
+image_create(IMAGE * image,
+			 uint32_t edged_width,
+			 uint32_t edged_height)
+{
+	return image_alloc(image, edged_width, edged_height, EDGE_SIZE);
+}
+
+void
+image_destroy(IMAGE * image,
+			  uint32_t edged_width,
+			  uint32_t edged_height)
+{
+	image_free(image, edged_width, EDGE_SIZE);
+}
+
+/* planes without the EDGE_SIZE border, for reference frames whose out of
+ * picture pixels are emulated when they are read (see image_padded_size) */
+int32_t
+image_create_noedge(IMAGE * image,
+					uint32_t width,
+					uint32_t height)
+{
+	return image_alloc(image, width, height, 0);
+}
+
+void
+image_destroy_noedge(IMAGE * image,
+					 uint32_t width,
+					 __unused uint32_t height)
+{
+	image_free(image, width, 0);
+}
+
 
 void
 image_swap(IMAGE * image1,
@@ -132,6 +167,58 @@ image_copy(IMAGE * image1,
 #define SETEDGES_BUG_AFTER		57
 #define SETEDGES_BUG_REFIXED		63
 
+/* size of the area the edges of a reference frame are extended from.
+ * According to the Standard Clause 7.6.4, padding is done starting at 16
+ * pixel width and height multiples. This was not respected in old xvids */
+void
+image_padded_size(uint32_t * width,
+				  uint32_t * height,
+				  int bs_version)
+{
+	if ((bs_version >= SETEDGES_BUG_BEFORE &&
+		bs_version <  SETEDGES_BUG_AFTER) || 
+		bs_version >= SETEDGES_BUG_REFIXED) {
+		*width  = (*width+15)&~15;
+		*height = (*height+15)&~15;
+	}
+}
+
+/* copies the w x h block at (x, y) of a width x height plane to dst, rows
+ * step plane rows apart (2 for a field). Pixels outside the plane repeat
+ * the nearest edge pixel, like a plane padded by image_setedges() */
+void
+image_emulate_edges(uint8_t * dst,
+					int dst_stride,
+					const uint8_t * plane,
+					int stride,
+					int width,
+					int height,
+					int x,
+					int y,
+					int w,
+					int h,
+					int step)
+{
+	/* columns taken from the left edge, the plane and the right edge */
+	const int left = MIN(MAX(-x, 0), w);
+	const int inside = MAX(MIN(x + w, width) - MAX(x, 0), 0);
+	const int right = w - left - inside;
+	int i;
+
+	for (i = 0; i < h; i++) {
+		const int row = MIN(MAX(y + i * step, 0), height - 1);
+		const uint8_t *src = plane + row * stride;
+
+		if (left)
+			memset(dst, src[0], left);
+		if (inside)
+			memcpy(dst + left, src + x + left, inside);
+		if (right)
+			memset(dst + left + inside, src[width - 1], right);
+		dst += dst_stride;
+	}
+}
+
 void
 image_setedges(IMAGE * image,
 			   uint32_t edged_width,
@@ -149,14 +236,7 @@ image_setedges(IMAGE * image,
 	dst = image->y - (EDGE_SIZE + EDGE_SIZE * edged_width);
 	src = image->y;
 
-	/* According to the Standard Clause 7.6.4, padding is done starting at 16
-	 * pixel width and height multiples. This was not respected in old xvids */
-	if ((bs_version >= SETEDGES_BUG_BEFORE &&
-		bs_version <  SETEDGES_BUG_AFTER) || 
-		bs_version >= SETEDGES_BUG_REFIXED) {
-		width  = (width+15)&~15;
-		height = (height+15)&~15;
-	}
+	image_padded_size(&width, &height, bs_version);
 
 	width2 = width/2;
 
@@ -636,6 +716,11 @@ image_output(IMAGE * image,
 	image_dump_yuvpgm(image, edged_width, width, height, "\\decode.pgm");
 */
 
+	/* the slice flag on a packed format only tells the decoder to convert each
+	   macroblock row right away (image_output_rows), here it's the whole picture */
+	if ((csp & ~XVID_CSP_VFLIP) != XVID_CSP_SLICE)
+		csp &= ~XVID_CSP_SLICE;
+
 	switch (csp & ~XVID_CSP_VFLIP) {
 	case XVID_CSP_RGB555:
 		safe_packed_conv(
@@ -653,6 +738,15 @@ image_output(IMAGE * image,
 			interlacing?yv12_to_rgb565i_c:yv12_to_rgb565_c, 2, interlacing);
 		return 0;
 
+	case XVID_CSP_RGB565 | XVID_CSP_ROTATE:
+		/* output rows are source columns, the stride checks of safe_packed_conv don't apply.
+		   interlaced chroma is converted as progressive */
+		if (width > 1 && height > 1)
+			yv12_to_rgb565_rot90_concept(
+				dst[0], dst_stride[0], image->y, image->u, image->v,
+				edged_width, edged_width2, width & ~1, height & ~1, (csp & XVID_CSP_VFLIP));
+		return 0;
+
     case XVID_CSP_BGR:
 		safe_packed_conv(
 			dst[0], dst_stride[0], image->y, image->u, image->v,
@@ -764,6 +858,38 @@ image_output(IMAGE * image,
 	return -1;
 }
 
+/* Converts the picture rows [y, y+rows) into a packed 16 bit output. dst and
+   dst_stride describe the whole picture, y and rows are multiples of 2 (4 when
+   interlaced). Used to convert a macroblock row while it is still cached. */
+int
+image_output_rows(IMAGE * image,
+			 uint32_t width,
+			 int height,
+			 uint32_t edged_width,
+			 uint8_t * dst[4],
+			 int dst_stride[4],
+			 int csp,
+			 int interlacing,
+			 int y,
+			 int rows)
+{
+	IMAGE band;
+	uint8_t * band_dst[4] = { dst[0], dst[1], dst[2], dst[3] };
+
+	band.y = image->y + y * edged_width;
+	band.u = image->u + (y/2) * (edged_width/2);
+	band.v = image->v + (y/2) * (edged_width/2);
+
+	if (csp & XVID_CSP_ROTATE) /* picture rows are output columns, the first one on the right */
+		band_dst[0] += ((csp & XVID_CSP_VFLIP) ? y : height - y - rows) * 2;
+	else
+		band_dst[0] += ((csp & XVID_CSP_VFLIP) ? height - y - rows : y) * dst_stride[0];
+
+	return image_output(&band, width, rows, edged_width, band_dst, dst_stride, csp, interlacing);
+}
+
+#ifndef XVID_DECODER_ONLY
+
 float
 image_psnr(IMAGE * orig_image,
 		   IMAGE * recon_image,
@@ -958,6 +1084,8 @@ void image_block_variance(IMAGE * orig_image,
 	}
 }
 
+#endif /* !XVID_DECODER_ONLY */
+
 #if 0
 
 #include <stdio.h>
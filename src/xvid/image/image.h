@@ -51,6 +51,13 @@ void image_destroy(IMAGE * image,
 				   uint32_t edged_width,
 				   uint32_t edged_height);
 
+int32_t image_create_noedge(IMAGE * image,
+							uint32_t width,
+							uint32_t height);
+void image_destroy_noedge(IMAGE * image,
+						  uint32_t width,
+						  uint32_t height);
+
 void image_swap(IMAGE * image1,
 				IMAGE * image2);
 
@@ -59,6 +66,22 @@ void image_copy(IMAGE * image1,
 				uint32_t edged_width,
 				uint32_t height);
 
+void image_padded_size(uint32_t * width,
+					   uint32_t * height,
+					   int bs_version);
+
+void image_emulate_edges(uint8_t * dst,
+						 int dst_stride,
+						 const uint8_t * plane,
+						 int stride,
+						 int width,
+						 int height,
+						 int x,
+						 int y,
+						 int w,
+						 int h,
+						 int step);
+
 void image_setedges(IMAGE * image,
 					uint32_t edged_width,
 					uint32_t edged_height,
@@ -112,6 +135,17 @@ int image_output(IMAGE * image,
 				 int csp,
 				 int interlaced);
 
+int image_output_rows(IMAGE * image,
+				 uint32_t width,
+				 int height,
+				 uint32_t edged_width,
+				 uint8_t * dst[4],
+				 int dst_stride[4],
+				 int csp,
+				 int interlaced,
+				 int y,
+				 int rows);
+
 
 
 int image_dump_yuvpgm(const IMAGE * image,
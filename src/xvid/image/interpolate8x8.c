@@ -132,10 +132,10 @@ interpolate8x8_halfpel_h_c(uint8_t * const dst,
 				uint32_t w0_next = (w0 >> 8) | (w1 << 24);
 				uint32_t w1_next = (w1 >> 8) | (w2 << 24);
 
-				uint32_t avg1 = (w0 | w0_next) - (((w0 ^ w0_next) >> 1) & mask);
+				uint32_t avg1 = (w0 & w0_next) + (((w0 ^ w0_next) >> 1) & mask);
 				d[0] = avg1;
 				
-				uint32_t avg2 = (w1 | w1_next) - (((w1 ^ w1_next) >> 1) & mask);
+				uint32_t avg2 = (w1 & w1_next) + (((w1 ^ w1_next) >> 1) & mask);
 				d[1] = avg2;
 			}
 		} else {
@@ -150,10 +150,10 @@ interpolate8x8_halfpel_h_c(uint8_t * const dst,
 				uint32_t w0_next = (w0 >> 8) | (w1 << 24);
 				uint32_t w1_next = (w1 >> 8) | (w2 << 24);
 
-				uint32_t avg1 = (w0 & w0_next) + (((w0 ^ w0_next) >> 1) & mask);
+				uint32_t avg1 = (w0 | w0_next) - (((w0 ^ w0_next) >> 1) & mask);
 				d[0] = avg1;
 				
-				uint32_t avg2 = (w1 & w1_next) + (((w1 ^ w1_next) >> 1) & mask);
+				uint32_t avg2 = (w1 | w1_next) - (((w1 ^ w1_next) >> 1) & mask);
 				d[1] = avg2;
 			}
 		}
@@ -275,11 +275,11 @@ interpolate8x8_halfpel_v_c(uint8_t * const dst,
 				
 				uint32_t a1 = s1[0];
 				uint32_t b1 = s2[0];
-				d[0] = (a1 | b1) - (((a1 ^ b1) >> 1) & mask);
+				d[0] = (a1 & b1) + (((a1 ^ b1) >> 1) & mask);
 				
 				uint32_t a2 = s1[1];
 				uint32_t b2 = s2[1];
-				d[1] = (a2 | b2) - (((a2 ^ b2) >> 1) & mask);
+				d[1] = (a2 & b2) + (((a2 ^ b2) >> 1) & mask);
 			}
 		} else {
 			for (j = 0; j < 8*stride; j+=stride) {
@@ -289,11 +289,11 @@ interpolate8x8_halfpel_v_c(uint8_t * const dst,
 				
 				uint32_t a1 = s1[0];
 				uint32_t b1 = s2[0];
-				d[0] = (a1 & b1) + (((a1 ^ b1) >> 1) & mask);
+				d[0] = (a1 | b1) - (((a1 ^ b1) >> 1) & mask);
 				
 				uint32_t a2 = s1[1];
 				uint32_t b2 = s2[1];
-				d[1] = (a2 & b2) + (((a2 ^ b2) >> 1) & mask);
+				d[1] = (a2 | b2) - (((a2 ^ b2) >> 1) & mask);
 			}
 		}
 	} else {
@@ -208,6 +208,62 @@ image_postproc(XVID_POSTPROC *tbls, IMAGE * img, int edged_width,
 	}
 }
 
+/* Deblocks as much of the picture as macroblock row mby allows, for output
+   while decoding. Call it for every row in order, once the row is in img.
+   Like image_postproc every horizontal edge of a block row is filtered before
+   its vertical edges, so the result is identical. When it returns all rows
+   above mby are final (all rows after the last one). Noise and brightness are
+   not handled here. */
+void
+image_postproc_mbrow(XVID_POSTPROC *tbls, IMAGE * img, int edged_width,
+				const MACROBLOCK * mbs, int mb_width, int mb_height, int mb_stride,
+				int flags, int bvop, int mby)
+{
+	const int stride = edged_width;
+	const int stride2 = edged_width / 2;
+	const int last = (mby == mb_height - 1);
+	int i, j;
+
+	/* luma, j in block units: the two horizontal edges inside this row, then the vertical
+	   edges of every block row no later edge reaches into (the lower half of the row
+	   above, the upper half of this one) */
+	if ((flags & XVID_DEBLOCKY))
+	{
+		int dering = flags & XVID_DERINGY;
+
+		for (j = MAX(1, 2*mby); j < 2*mby + 2; j++)
+		for (i = 0; i < mb_width*2; i++)
+			deblock8x8_h(tbls, img->y + j*8*stride + i*8, stride, mbs[(j/2)*mb_stride + (i/2)].quant, dering);
+
+		for (j = MAX(0, 2*mby - 1); j < 2*mby + (last ? 2 : 1); j++)
+		for (i = 1; i < mb_width*2; i++)
+			deblock8x8_v(tbls, img->y + j*8*stride + i*8, stride, mbs[(j/2)*mb_stride + (i/2)].quant, dering);
+	}
+
+	/* chroma: the edge on top of this row finishes the row above */
+	if ((flags & XVID_DEBLOCKUV))
+	{
+		int dering = flags & XVID_DERINGUV;
+
+		if (mby > 0)
+		for (i = 0; i < mb_width; i++)
+		{
+			deblock8x8_h(tbls, img->u + mby*8*stride2 + i*8, stride2, mbs[mby*mb_stride + i].quant, dering);
+			deblock8x8_h(tbls, img->v + mby*8*stride2 + i*8, stride2, mbs[mby*mb_stride + i].quant, dering);
+		}
+
+		for (j = MAX(0, mby - 1); j < mby + (last ? 1 : 0); j++)
+		for (i = 1; i < mb_width; i++)
+		{
+			deblock8x8_v(tbls, img->u + j*8*stride2 + i*8, stride2, mbs[j*mb_stride + i].quant, dering);
+			deblock8x8_v(tbls, img->v + j*8*stride2 + i*8, stride2, mbs[j*mb_stride + i].quant, dering);
+		}
+	}
+
+	if (last && !bvop)
+		tbls->prev_quant = mbs->quant;
+}
+
 /******************************************************************************/
 
 void init_deblock(XVID_POSTPROC *tbls)
@@ -69,6 +69,11 @@ image_postproc(XVID_POSTPROC *tbls, IMAGE * img, int edged_width,
 				const MACROBLOCK * mbs, int mb_width, int mb_height, int mb_stride,
 				int flags, int brightness, int frame_num, int bvop, int threads);
 
+void
+image_postproc_mbrow(XVID_POSTPROC *tbls, IMAGE * img, int edged_width,
+				const MACROBLOCK * mbs, int mb_width, int mb_height, int mb_stride,
+				int flags, int bvop, int mby);
+
 void deblock8x8_h(XVID_POSTPROC *tbls, uint8_t *img, int stride, int quant, int dering);
 void deblock8x8_v(XVID_POSTPROC *tbls, uint8_t *img, int stride, int quant, int dering);
 
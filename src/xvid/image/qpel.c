@@ -443,6 +443,212 @@ void xvid_Init_QP(void)
 
 }
 
+/* Per position block kernels
+ ****************************************************************************/
+
+/* one line of size pixels filtered from size+1 source pixels, the pixels
+ * being src_step and dst_step bytes apart. avrg 1 and 2 average the filtered
+ * pixel with the source pixel at or after it (the quarter positions), add
+ * averages the result with the prediction already in dst (B-VOPs). They
+ * are forced inline, so each pass gets its own constant folded copy */
+
+#define QP_S(k)  ((int32_t)src[(k)*src_step])
+#define QP_MID(i) \
+	(-(QP_S((i)-3)+QP_S((i)+4)) + 3*(QP_S((i)-2)+QP_S((i)+3)) \
+	 - 6*(QP_S((i)-1)+QP_S((i)+2)) + 20*(QP_S(i)+QP_S((i)+1)))
+#define QP_OUT(i,C) \
+	qpel_out(dst + (i)*dst_step, (C), src + ((i) + (avrg == 2))*src_step, rnd, avrg, add)
+
+static __inline __attribute__((always_inline)) void
+qpel_out(uint8_t *d, int32_t C, const uint8_t *s, int32_t rnd, const int avrg, const int add)
+{
+	C += 16 - rnd;
+	if (C < 0) C = 0; else if (C > (255<<5)) C = 255; else C = C >> 5;
+	if (avrg)
+		C = (C + *s + 1 - rnd) >> 1;
+	if (add)
+		C = (C + *d + 1) >> 1;
+	*d = C;
+}
+
+static __inline __attribute__((always_inline)) void
+qpel_line(uint8_t *dst, const int32_t dst_step,
+		  const uint8_t *src, const int32_t src_step,
+		  const int size, const int32_t rnd, const int avrg, const int add)
+{
+	QP_OUT(0, 14*QP_S(0) + 23*QP_S(1) - 7*QP_S(2) + 3*QP_S(3) - QP_S(4));
+	QP_OUT(1, -3*(QP_S(0)-QP_S(4)) + 19*QP_S(1) + 20*QP_S(2) - 6*QP_S(3) - QP_S(5));
+	QP_OUT(2, 2*QP_S(0) - 6*(QP_S(1)+QP_S(4)) + 20*(QP_S(2)+QP_S(3)) + 3*QP_S(5) - QP_S(6));
+	QP_OUT(3, QP_MID(3));
+	QP_OUT(4, QP_MID(4));
+	if (size == 16) {
+		QP_OUT( 5, QP_MID( 5));
+		QP_OUT( 6, QP_MID( 6));
+		QP_OUT( 7, QP_MID( 7));
+		QP_OUT( 8, QP_MID( 8));
+		QP_OUT( 9, QP_MID( 9));
+		QP_OUT(10, QP_MID(10));
+		QP_OUT(11, QP_MID(11));
+		QP_OUT(12, QP_MID(12));
+	}
+	QP_OUT(size-3, -QP_S(size-6) + 3*QP_S(size-5) - 6*(QP_S(size-4)+QP_S(size-1))
+		   + 20*(QP_S(size-3)+QP_S(size-2)) + 2*QP_S(size));
+	QP_OUT(size-2, -QP_S(size-5) + 3*(QP_S(size-4)-QP_S(size)) - 6*QP_S(size-3)
+		   + 20*QP_S(size-2) + 19*QP_S(size-1));
+	QP_OUT(size-1, -QP_S(size-4) + 3*QP_S(size-3) - 7*QP_S(size-2)
+		   + 23*QP_S(size-1) + 14*QP_S(size));
+}
+
+#undef QP_S
+#undef QP_MID
+#undef QP_OUT
+
+/* the passes filter count lines of a block, the rows for H_ and the columns
+ * for V_, the strides being those of the rows */
+
+typedef void (QP_PASS)(uint8_t *dst, int32_t dst_stride,
+					   const uint8_t *src, int32_t src_stride,
+					   int32_t count, int32_t rnd);
+
+#define QP_PASS_FUNCS(NAME,SIZE,AVRG,ADD) \
+static void H_##NAME(uint8_t *dst, int32_t dst_stride, \
+					 const uint8_t *src, int32_t src_stride, \
+					 int32_t count, int32_t rnd) \
+{ \
+	while (count-- > 0) { \
+		qpel_line(dst, 1, src, 1, SIZE, rnd, AVRG, ADD); \
+		dst += dst_stride; \
+		src += src_stride; \
+	} \
+} \
+static void V_##NAME(uint8_t *dst, int32_t dst_stride, \
+					 const uint8_t *src, int32_t src_stride, \
+					 int32_t count, int32_t rnd) \
+{ \
+	/* the block on the stack gets its own copy, its stride being constant */ \
+	if (src_stride == SIZE) { \
+		for (; count > 0; count--, dst++, src++) \
+			qpel_line(dst, dst_stride, src, SIZE, SIZE, rnd, AVRG, ADD); \
+	} else { \
+		for (; count > 0; count--, dst++, src++) \
+			qpel_line(dst, dst_stride, src, src_stride, SIZE, rnd, AVRG, ADD); \
+	} \
+}
+
+QP_PASS_FUNCS(Pass_16,             16, 0, 0)
+QP_PASS_FUNCS(Pass_Avrg_16,        16, 1, 0)
+QP_PASS_FUNCS(Pass_Avrg_Up_16,     16, 2, 0)
+QP_PASS_FUNCS(Pass_16_Add,         16, 0, 1)
+QP_PASS_FUNCS(Pass_Avrg_16_Add,    16, 1, 1)
+QP_PASS_FUNCS(Pass_Avrg_Up_16_Add, 16, 2, 1)
+QP_PASS_FUNCS(Pass_8,               8, 0, 0)
+QP_PASS_FUNCS(Pass_Avrg_8,          8, 1, 0)
+QP_PASS_FUNCS(Pass_Avrg_Up_8,       8, 2, 0)
+QP_PASS_FUNCS(Pass_8_Add,           8, 0, 1)
+QP_PASS_FUNCS(Pass_Avrg_8_Add,      8, 1, 1)
+QP_PASS_FUNCS(Pass_Avrg_Up_8_Add,   8, 2, 1)
+
+/* A position filtered in one direction reads the block straight from the
+ * plane. Filtering in both directions goes through a block on the stack, the
+ * size+1 rows filtered horizontally packed at the block width, so the
+ * intermediate stays in a few cache lines instead of spanning 17 rows of a
+ * frame sized scratch plane. The horizontal result is clipped to 8 bits in
+ * between as the standard has it, so the two passes can't be folded into one
+ * 2D filter. h_pass of a 2D position never adds, v_pass does the averaging
+ * with dst for B-VOPs */
+static __inline void
+qpel_block(uint8_t *dst, const uint8_t *src, int32_t stride, int32_t rnd,
+		   const int size, QP_PASS *h_pass, QP_PASS *v_pass)
+{
+	if (v_pass == NULL) {
+		h_pass(dst, stride, src, stride, size, rnd);
+	} else if (h_pass == NULL) {
+		v_pass(dst, stride, src, stride, size, rnd);
+	} else {
+		uint8_t tmp[17*16];
+
+		h_pass(tmp, size, src, stride, size + 1, rnd);
+		v_pass(dst, stride, tmp, size, size, rnd);
+	}
+}
+
+/* position 0 is the integer vector, a copy (or an average for B-VOPs) */
+
+static void
+Block_16_0(uint8_t *dst, const uint8_t *src, int32_t stride, __unused int32_t rnd)
+{
+	transfer8x8_copy(dst, src, stride);
+	transfer8x8_copy(dst+8, src+8, stride);
+	transfer8x8_copy(dst+8*stride, src+8*stride, stride);
+	transfer8x8_copy(dst+8*stride+8, src+8*stride+8, stride);
+}
+
+static void
+Block_16_Add_0(uint8_t *dst, const uint8_t *src, int32_t stride, int32_t rnd)
+{
+	interpolate8x8_halfpel_add(dst, src, stride, rnd);
+	interpolate8x8_halfpel_add(dst+8, src+8, stride, rnd);
+	interpolate8x8_halfpel_add(dst+8*stride, src+8*stride, stride, rnd);
+	interpolate8x8_halfpel_add(dst+8*stride+8, src+8*stride+8, stride, rnd);
+}
+
+static void
+Block_8_0(uint8_t *dst, const uint8_t *src, int32_t stride, __unused int32_t rnd)
+{
+	transfer8x8_copy(dst, src, stride);
+}
+
+static void
+Block_8_Add_0(uint8_t *dst, const uint8_t *src, int32_t stride, int32_t rnd)
+{
+	interpolate8x8_halfpel_add(dst, src, stride, rnd);
+}
+
+#define QP_BLOCK_FUNC(NAME,SIZE,H,V) \
+static void NAME(uint8_t *dst, const uint8_t *src, int32_t stride, int32_t rnd) \
+{ \
+	qpel_block(dst, src, stride, rnd, SIZE, H, V); \
+}
+
+/* the passes of each position, see the table above interpolate16x16_quarterpel() */
+#define QP_BLOCK_FUNCS(SIZE,ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_1,  SIZE, H_Pass_Avrg_##SIZE##ADD, NULL) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_2,  SIZE, H_Pass_##SIZE##ADD, NULL) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_3,  SIZE, H_Pass_Avrg_Up_##SIZE##ADD, NULL) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_4,  SIZE, NULL, V_Pass_Avrg_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_5,  SIZE, H_Pass_Avrg_##SIZE, V_Pass_Avrg_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_6,  SIZE, H_Pass_##SIZE, V_Pass_Avrg_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_7,  SIZE, H_Pass_Avrg_Up_##SIZE, V_Pass_Avrg_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_8,  SIZE, NULL, V_Pass_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_9,  SIZE, H_Pass_Avrg_##SIZE, V_Pass_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_10, SIZE, H_Pass_##SIZE, V_Pass_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_11, SIZE, H_Pass_Avrg_Up_##SIZE, V_Pass_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_12, SIZE, NULL, V_Pass_Avrg_Up_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_13, SIZE, H_Pass_Avrg_##SIZE, V_Pass_Avrg_Up_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_14, SIZE, H_Pass_##SIZE, V_Pass_Avrg_Up_##SIZE##ADD) \
+QP_BLOCK_FUNC(Block_##SIZE##ADD##_15, SIZE, H_Pass_Avrg_Up_##SIZE, V_Pass_Avrg_Up_##SIZE##ADD)
+
+#define QP_BLOCK_TABLE(SIZE,ADD) { \
+	Block_##SIZE##ADD##_0,  Block_##SIZE##ADD##_1,  Block_##SIZE##ADD##_2,  Block_##SIZE##ADD##_3, \
+	Block_##SIZE##ADD##_4,  Block_##SIZE##ADD##_5,  Block_##SIZE##ADD##_6,  Block_##SIZE##ADD##_7, \
+	Block_##SIZE##ADD##_8,  Block_##SIZE##ADD##_9,  Block_##SIZE##ADD##_10, Block_##SIZE##ADD##_11, \
+	Block_##SIZE##ADD##_12, Block_##SIZE##ADD##_13, Block_##SIZE##ADD##_14, Block_##SIZE##ADD##_15 }
+
+QP_BLOCK_FUNCS(16,)
+QP_BLOCK_FUNCS(16,_Add)
+QP_BLOCK_FUNCS(8,)
+QP_BLOCK_FUNCS(8,_Add)
+
+XVID_QP_BLOCK *const xvid_QP_Block_16[16] = QP_BLOCK_TABLE(16,);
+XVID_QP_BLOCK *const xvid_QP_Block_Add_16[16] = QP_BLOCK_TABLE(16,_Add);
+XVID_QP_BLOCK *const xvid_QP_Block_8[16] = QP_BLOCK_TABLE(8,);
+XVID_QP_BLOCK *const xvid_QP_Block_Add_8[16] = QP_BLOCK_TABLE(8,_Add);
+
+#undef QP_PASS_FUNCS
+#undef QP_BLOCK_FUNC
+#undef QP_BLOCK_FUNCS
+#undef QP_BLOCK_TABLE
+
 #endif /* !XVID_AUTO_INCLUDE */
 
 #if defined(XVID_AUTO_INCLUDE) && defined(REFERENCE_CODE)
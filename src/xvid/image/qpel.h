@@ -77,6 +77,17 @@ extern XVID_QP_FUNCS xvid_QP_Add_Funcs_C;   /* for B-frames */
 extern XVID_QP_FUNCS *xvid_QP_Funcs;      /* <- main pointer for enc/dec structure */
 extern XVID_QP_FUNCS *xvid_QP_Add_Funcs;  /* <- main pointer for enc/dec structure */
 
+/* whole block prediction, one kernel per quarterpel position indexed by
+ * (dx&3) | ((dy&3)<<2), src being the block at the integer vector. They
+ * need no scratch plane, the Add ones average with dst for B-VOPs */
+
+typedef void (XVID_QP_BLOCK)(uint8_t *dst, const uint8_t *src, int32_t stride, int32_t rounding);
+
+extern XVID_QP_BLOCK *const xvid_QP_Block_16[16];
+extern XVID_QP_BLOCK *const xvid_QP_Block_Add_16[16];
+extern XVID_QP_BLOCK *const xvid_QP_Block_8[16];
+extern XVID_QP_BLOCK *const xvid_QP_Block_Add_8[16];
+
 /*****************************************************************************
  * macros
  ****************************************************************************/
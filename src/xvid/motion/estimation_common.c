@@ -34,26 +34,6 @@
 #include "motion_inlines.h"
 
 
-/*****************************************************************************
- * Modified rounding tables
- * Original tables see ISO spec tables 7-6 -> 7-9
- ****************************************************************************/
-
-const uint32_t roundtab[16] =
-{0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2 };
-
-/* K = 4 */
-const uint32_t roundtab_76[16] =
-{ 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 1, 1 };
-
-/* K = 2 */
-const uint32_t roundtab_78[8] =
-{ 0, 0, 1, 1, 0, 0, 0, 1  };
-
-/* K = 1 */
-const uint32_t roundtab_79[4] =
-{ 0, 1, 0, 0 };
-
 const int xvid_me_lambda_vec16[32] =
 	{     0    ,(int)(1.0 * NEIGH_TEND_16X16 + 0.5),
 	(int)(2.0*NEIGH_TEND_16X16 + 0.5), (int)(3.0*NEIGH_TEND_16X16 + 0.5),
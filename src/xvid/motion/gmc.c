@@ -26,6 +26,7 @@
 #include "../portab.h"
 #include "../global.h"
 #include "../encoder.h"
+#include "../image/image.h"
 #include "gmc.h"
 #include "../utils/emms.h"
 
@@ -98,6 +99,8 @@ void Predict_16x16_C(const NEW_GMC_DATA * const This,
 {
 	const int W = This->sW;
 	const int H	= This->sH;
+	const int pW = This->pW;
+	const int pH = This->pH;
 	const int rho = 3 - This->accuracy;
 	const int Rounder = ( (1<<7) - (rounding<<(2*rho)) ) << 16;
 
@@ -117,29 +120,36 @@ void Predict_16x16_C(const NEW_GMC_DATA * const This,
 		Uo += dUy; Vo += dVy;
 		for (i=-16; i<0; ++i) {
 			unsigned int f0, f1, ri = 16, rj = 16;
-			int Offset;
+			int x0, y0, x1, y1;
 			int u = ( U >> 16 ) << rho;
 			int v = ( V >> 16 ) << rho;
 
 			U += dUx; V += dVx;
 
-			if (u > 0 && u <= W) { ri = MTab[u&15]; Offset = u>>4;	}
+			if (u > 0 && u <= W) { ri = MTab[u&15]; x0 = u>>4;	}
 			else {
-				if (u > W) Offset = W>>4;
-				else Offset = 0;
+				if (u > W) x0 = W>>4;
+				else x0 = 0;
 				ri = MTab[0];
 			}
 
-			if (v > 0 && v <= H) { rj = MTab[v&15]; Offset += (v>>4)*srcstride; }
+			if (v > 0 && v <= H) { rj = MTab[v&15]; y0 = v>>4; }
 			else {
-				if (v > H) Offset += (H>>4)*srcstride;
+				if (v > H) y0 = H>>4;
+				else y0 = 0;
 				rj = MTab[0];
 			}
 
-			f0	= src[Offset + 0];
-			f0 |= src[Offset + 1] << 16;
-			f1	= src[Offset + srcstride + 0];
-			f1 |= src[Offset + srcstride + 1] << 16;
+			/* the right/bottom neighbour may be past the plane */
+			x1 = MIN(x0 + 1, pW - 1);
+			x0 = MIN(x0, pW - 1);
+			y1 = MIN(y0 + 1, pH - 1) * srcstride;
+			y0 = MIN(y0, pH - 1) * srcstride;
+
+			f0	= src[y0 + x0];
+			f0 |= src[y0 + x1] << 16;
+			f1	= src[y1 + x0];
+			f1 |= src[y1 + x1] << 16;
 			f0 = (ri*f0)>>16;
 			f1 = (ri*f1) & 0x0fff0000;
 			f0 |= f1;
@@ -159,6 +169,8 @@ void Predict_8x8_C(const NEW_GMC_DATA * const This,
 {
 	const int W	 = This->sW >> 1;
 	const int H	 = This->sH >> 1;
+	const int pW = This->pW >> 1;
+	const int pH = This->pH >> 1;
 	const int rho = 3-This->accuracy;
 	const int32_t Rounder = ( 128 - (rounding<<(2*rho)) ) << 16;
 
@@ -179,7 +191,7 @@ void Predict_8x8_C(const NEW_GMC_DATA * const This,
 		Uo += dUy; Vo += dVy;
 
 		for (i=-8; i<0; ++i) {
-			int Offset;
+			int x0, y0, x1, y1;
 			uint32_t f0, f1, ri, rj;
 			int32_t u, v;
 
@@ -189,25 +201,31 @@ void Predict_8x8_C(const NEW_GMC_DATA * const This,
 
 			if (u > 0 && u <= W) {
 				ri = MTab[u&15];
-				Offset = u>>4;
+				x0 = u>>4;
 			} else {
-				if (u>W) Offset = W>>4;
-				else Offset = 0;
+				if (u>W) x0 = W>>4;
+				else x0 = 0;
 				ri = MTab[0];
 			}
 
 			if (v > 0 && v <= H) {
 				rj = MTab[v&15];
-				Offset += (v>>4)*srcstride;
+				y0 = v>>4;
 			} else {
-				if (v>H) Offset += (H>>4)*srcstride;
+				if (v>H) y0 = H>>4;
+				else y0 = 0;
 				rj = MTab[0];
 			}
 
-			f0	= uSrc[Offset + 0];
-			f0 |= uSrc[Offset + 1] << 16;
-			f1	= uSrc[Offset + srcstride + 0];
-			f1 |= uSrc[Offset + srcstride + 1] << 16;
+			x1 = MIN(x0 + 1, pW - 1);
+			x0 = MIN(x0, pW - 1);
+			y1 = MIN(y0 + 1, pH - 1) * srcstride;
+			y0 = MIN(y0, pH - 1) * srcstride;
+
+			f0	= uSrc[y0 + x0];
+			f0 |= uSrc[y0 + x1] << 16;
+			f1	= uSrc[y1 + x0];
+			f1 |= uSrc[y1 + x1] << 16;
 			f0 = (ri*f0)>>16;
 			f1 = (ri*f1) & 0x0fff0000;
 			f0 |= f1;
@@ -215,10 +233,10 @@ void Predict_8x8_C(const NEW_GMC_DATA * const This,
 
 			uDst[i] = (uint8_t)f0;
 
-			f0	= vSrc[Offset + 0];
-			f0 |= vSrc[Offset + 1] << 16;
-			f1	= vSrc[Offset + srcstride + 0];
-			f1 |= vSrc[Offset + srcstride + 1] << 16;
+			f0	= vSrc[y0 + x0];
+			f0 |= vSrc[y0 + x1] << 16;
+			f1	= vSrc[y1 + x0];
+			f1 |= vSrc[y1 + x1] << 16;
 			f0 = (ri*f0)>>16;
 			f1 = (ri*f1) & 0x0fff0000;
 			f0 |= f1;
@@ -279,20 +297,32 @@ void Predict_1pt_16x16_C(const NEW_GMC_DATA * const This,
 	uint32_t rj = MTab[vo & 15];
 	int i, j;
 
-	int32_t Offset;
-	if (vo>=(-16<<4) && vo<=H) Offset = (vo>>4)*srcstride;
+	int32_t Offset, x0, y0;
+	uint8_t edge[17*17];
+	if (vo>=(-16<<4) && vo<=H) y0 = (vo>>4);
 	else {
-		if (vo>H) Offset = ( H>>4)*srcstride;
-		else Offset =-16*srcstride;
+		if (vo>H) y0 = ( H>>4);
+		else y0 =-16;
 		rj = MTab[0];
 	}
-	if (uo>=(-16<<4) && uo<=W) Offset += (uo>>4);
+	if (uo>=(-16<<4) && uo<=W) x0 = (uo>>4);
 	else {
-		if (uo>W) Offset += (W>>4);
-		else Offset -= 16;
+		if (uo>W) x0 = (W>>4);
+		else x0 = -16;
 		ri = MTab[0];
 	}
 
+	/* the 17x17 source block, with the edge pixels repeated where it
+	 * leaves the reference plane */
+	if (x0 < 0 || y0 < 0 || x0 + 17 > This->pW || y0 + 17 > This->pH) {
+		image_emulate_edges(edge, 17, Src, srcstride, This->pW, This->pH,
+							x0, y0, 17, 17, 1);
+		Src = edge;
+		srcstride = 17;
+		Offset = 0;
+	}
+	else Offset = y0*srcstride + x0;
+
 	Dst += 16;
 
 	for(j=16; j>0; --j, Offset+=srcstride-16)
@@ -331,20 +361,33 @@ void Predict_1pt_8x8_C(const NEW_GMC_DATA * const This,
 	uint32_t rrj = MTab[vo & 15];
 	int i, j;
 
-	int32_t Offset;
-	if (vo>=(-8<<4) && vo<=H) Offset = (vo>>4)*srcstride;
+	int32_t Offset, x0, y0;
+	uint8_t uEdge[9*9], vEdge[9*9];
+	if (vo>=(-8<<4) && vo<=H) y0 = (vo>>4);
 	else {
-		if (vo>H) Offset = ( H>>4)*srcstride;
-		else Offset =-8*srcstride;
+		if (vo>H) y0 = ( H>>4);
+		else y0 =-8;
 		rrj = MTab[0];
 	}
-	if (uo>=(-8<<4) && uo<=W) Offset += (uo>>4);
+	if (uo>=(-8<<4) && uo<=W) x0 = (uo>>4);
 	else {
-		if (uo>W) Offset += ( W>>4);
-		else Offset -= 8;
+		if (uo>W) x0 = ( W>>4);
+		else x0 = -8;
 		rri = MTab[0];
 	}
 
+	if (x0 < 0 || y0 < 0 || x0 + 9 > This->pW/2 || y0 + 9 > This->pH/2) {
+		image_emulate_edges(uEdge, 9, uSrc, srcstride, This->pW/2, This->pH/2,
+							x0, y0, 9, 9, 1);
+		image_emulate_edges(vEdge, 9, vSrc, srcstride, This->pW/2, This->pH/2,
+							x0, y0, 9, 9, 1);
+		uSrc = uEdge;
+		vSrc = vEdge;
+		srcstride = 9;
+		Offset = 0;
+	}
+	else Offset = y0*srcstride + x0;
+
 	uDst += 8;
 	vDst += 8;
 	for(j=8; j>0; --j, Offset+=srcstride-8)
@@ -620,6 +663,10 @@ void generate_GMCparameters( int nb_pts, const int accuracy,
 {
 	gmc->sW = width	<< 4;
 	gmc->sH = height << 4;
+	/* edges are extended from the macroblock aligned size, callers with
+	 * other reference planes override this */
+	gmc->pW = (width + 15) & ~15;
+	gmc->pH = (height + 15) & ~15;
 	gmc->accuracy = accuracy;
 	gmc->num_wp = nb_pts;
 
@@ -32,7 +32,7 @@
 #include "../global.h"
 
 /*****************************************************************************
- * Modified rounding tables -- defined in estimation_common.c
+ * Modified rounding tables -- defined in utils/sram_tables.c
  * Original tables see ISO spec tables 7-6 -> 7-9
  ****************************************************************************/
 
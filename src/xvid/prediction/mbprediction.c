@@ -419,6 +419,8 @@ add_acdc(MACROBLOCK * pMB,
 /*****************************************************************************
  ****************************************************************************/
 
+#ifndef XVID_DECODER_ONLY
+
 /* encoder: subtract predictors from qcoeff[] and calculate S1/S2
 
 returns sum of coeefficients *saved* if prediction is enabled
@@ -605,6 +607,8 @@ MBPrediction(FRAMEINFO * frame,
 	}
 }
 
+#endif /* !XVID_DECODER_ONLY */
+
 static const VECTOR zeroMV = { 0, 0 };
 
 VECTOR
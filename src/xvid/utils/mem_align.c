@@ -27,10 +27,45 @@
 #include <stdio.h>
 #include "mem_align.h"
 
-/* SRAM Context */
+/* SRAM Context
+ *
+ * The pool is a stack of blocks. Freeing a block only marks it, the top of the
+ * stack then drops back over every freed block on it. Allocations freed in
+ * any order are reclaimed once nothing allocated after them is still in use,
+ * which covers a decoder's blocks on resize and destroy. Requests that don't
+ * fit (or would need more than SRAM_MAX_BLOCKS blocks) spill to the heap and
+ * are counted, see xvid_sram_stats() */
+
+#define SRAM_MAX_BLOCKS 64
+
 static uint8_t *sram_pool_base = NULL;
 static unsigned int sram_pool_size = 0;
 static unsigned int sram_pool_usage = 0;
+static unsigned int sram_pool_peak = 0;
+static unsigned int sram_spills = 0;
+static unsigned int sram_spilled_bytes = 0;
+
+static unsigned int sram_block_count = 0;
+static unsigned int sram_block_start[SRAM_MAX_BLOCKS]; /* usage before the block and its alignment */
+static uint8_t *sram_block_ptr[SRAM_MAX_BLOCKS];
+static uint8_t sram_block_live[SRAM_MAX_BLOCKS];
+
+static void
+xvid_free_sram(uint8_t *mem_ptr)
+{
+	unsigned int i = sram_block_count;
+
+	while (i > 0 && sram_block_ptr[i - 1] != mem_ptr)
+		i--;
+	if (i == 0)
+		return;
+	sram_block_live[i - 1] = 0;
+
+	while (sram_block_count > 0 && !sram_block_live[sram_block_count - 1]) {
+		sram_block_count--;
+		sram_pool_usage = sram_block_start[sram_block_count];
+	}
+}
 
 /*****************************************************************************
  * xvid_malloc
@@ -117,10 +152,11 @@ xvid_free(void *mem_ptr)
 	if (mem_ptr == NULL)
 		return;
 
-	/* If pointer is in SRAM pool, do nothing (it's persistent/bump allocated) */
+	/* SRAM blocks go back to the pool, see xvid_free_sram() */
 	if (sram_pool_base && 
 		(uint8_t*)mem_ptr >= sram_pool_base && 
 		(uint8_t*)mem_ptr < (sram_pool_base + sram_pool_size)) {
+		xvid_free_sram((uint8_t*)mem_ptr);
 		return;
 	}
 
@@ -143,6 +179,10 @@ xvid_init_sram(void *base, unsigned int size)
 	sram_pool_base = (uint8_t*)base;
 	sram_pool_size = size;
 	sram_pool_usage = 0;
+	sram_pool_peak = 0;
+	sram_spills = 0;
+	sram_spilled_bytes = 0;
+	sram_block_count = 0;
 }
 
 void *
@@ -171,12 +211,32 @@ xvid_malloc_sram(size_t size, uint8_t alignment)
 	}
 
 	/* check overflow */
-	if ((aligned_addr + size) <= ((uintptr_t)sram_pool_base + sram_pool_size)) {
+	if ((aligned_addr + size) <= ((uintptr_t)sram_pool_base + sram_pool_size) &&
+		sram_block_count < SRAM_MAX_BLOCKS) {
 		ptr = (uint8_t*)aligned_addr;
+		sram_block_start[sram_block_count] = sram_pool_usage;
+		sram_block_ptr[sram_block_count] = ptr;
+		sram_block_live[sram_block_count] = 1;
+		sram_block_count++;
 		sram_pool_usage = (aligned_addr + size) - (uintptr_t)sram_pool_base;
+		if (sram_pool_usage > sram_pool_peak)
+			sram_pool_peak = sram_pool_usage;
 		return (void*)ptr;
 	}
 
 	/* Fallback to SDRAM if SRAM full */
+	sram_spills++;
+	sram_spilled_bytes += size;
 	return xvid_malloc(size, alignment);
 }
+
+void
+xvid_sram_stats(unsigned int *size, unsigned int *used, unsigned int *peak,
+				unsigned int *spills, unsigned int *spilled_bytes)
+{
+	*size = sram_pool_size;
+	*used = sram_pool_usage;
+	*peak = sram_pool_peak;
+	*spills = sram_spills;
+	*spilled_bytes = sram_spilled_bytes;
+}
@@ -35,5 +35,7 @@ void xvid_free(void *mem_ptr);
 /* SRAM Allocator */
 void xvid_init_sram(void *base, unsigned int size);
 void *xvid_malloc_sram(size_t size, uint8_t alignment);
+void xvid_sram_stats(unsigned int *size, unsigned int *used, unsigned int *peak,
+					 unsigned int *spills, unsigned int *spilled_bytes);
 
 #endif							/* _MEM_ALIGN_H_ */
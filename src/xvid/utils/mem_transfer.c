@@ -23,6 +23,8 @@
  *
  ****************************************************************************/
 
+#include <string.h>
+
 #include "../global.h"
 #include "mem_transfer.h"
 
@@ -36,12 +38,20 @@ TRANSFER_8TO16SUBRO_PTR  transfer_8to16subro;
 TRANSFER_8TO16SUB2_PTR transfer_8to16sub2;
 TRANSFER_8TO16SUB2RO_PTR transfer_8to16sub2ro;
 TRANSFER_16TO8ADD_PTR  transfer_16to8add;
+TRANSFER_16TO8DC_PTR transfer_16to8copy_dc;
+TRANSFER_16TO8DC_PTR transfer_16to8add_dc;
 
 TRANSFER8X8_COPY_PTR transfer8x8_copy;
 TRANSFER8X4_COPY_PTR transfer8x4_copy;
 
 #define USE_REFERENCE_C
 
+#if defined(__GNUC__) || defined(__clang__)
+  typedef uint32_t u32_alias __attribute__((__may_alias__));
+#else
+  typedef uint32_t u32_alias;
+#endif
+
 /*****************************************************************************
  *
  * All these functions are used to transfer data from a 8 bit data array
@@ -253,6 +263,96 @@ transfer_16to8add_c(uint8_t * const dst,
 	}
 }
 
+/*
+ * transfer_16to8copy/transfer_16to8add for a source block that is VALUE in
+ * all 64 positions:
+ *
+ *    DST (8bit)  = max(min(VALUE, 255), 0)
+ *    DST (8bit)  = max(min(DST+VALUE, 255), 0)
+ */
+void
+transfer_16to8copy_dc_c(uint8_t * const dst,
+						const int16_t value,
+						uint32_t stride)
+{
+	const uint8_t pixel = (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		memset(dst + j * stride, pixel, 8);
+	}
+}
+
+void
+transfer_16to8add_dc_c(uint8_t * const dst,
+					   const int16_t value,
+					   uint32_t stride)
+{
+	int i, j;
+
+	for (j = 0; j < 8; j++) {
+		uint8_t * const row = dst + j * stride;
+		for (i = 0; i < 8; i++) {
+			int16_t pixel = (int16_t) row[i] + value;
+
+			if (pixel < 0) {
+				pixel = 0;
+			} else if (pixel > 255) {
+				pixel = 255;
+			}
+			row[i] = (uint8_t) pixel;
+		}
+	}
+}
+
+/*
+ * transfer_16to8add_dc four pixels per 32 bit word, same output as the C
+ * version for any value. The value is the same for all pixels, so the sum
+ * can only clamp one way: up to 255 for a positive value, down to 0 for a
+ * negative one, which is the same saturating add on the inverted pixels.
+ * Needs a word aligned dst and stride, little endian.
+ */
+
+/* bytewise x + y, saturating at 255 */
+static __inline uint32_t
+add_saturate_bytes(const uint32_t x, const uint32_t y)
+{
+	const uint32_t low = (x & 0x7F7F7F7Fu) + (y & 0x7F7F7F7Fu);
+	/* bit 7 of the bytes that carry out */
+	const uint32_t carry = ((x & y) | ((x | y) & low)) & 0x80808080u;
+
+	return (low ^ ((x ^ y) & 0x80808080u)) | (carry - (carry >> 7)) | carry;
+}
+
+void
+transfer_16to8add_dc_swar(uint8_t * const dst,
+						  const int16_t value,
+						  uint32_t stride)
+{
+	const uint32_t invert = value < 0 ? 0xFFFFFFFFu : 0;
+	uint32_t add;
+	int j;
+
+	/* past 32512 the int16_t sum of the C version can wrap */
+	if ((((uintptr_t)dst | stride) & 3) || value > 32767 - 255) {
+		transfer_16to8add_dc_c(dst, value, stride);
+		return;
+	}
+
+	if (value <= -255 || value >= 255) {
+		transfer_16to8copy_dc_c(dst, value, stride);
+		return;
+	}
+
+	add = (uint32_t)(value < 0 ? -value : value) * 0x01010101u;
+	for (j = 0; j < 8; j++) {
+		u32_alias *d = (u32_alias *)(dst + j * stride);
+
+		d[0] = add_saturate_bytes(d[0] ^ invert, add) ^ invert;
+		d[1] = add_saturate_bytes(d[1] ^ invert, add) ^ invert;
+	}
+}
+
 /*
  * SRC - the source buffer
  * DST - the destination buffer
@@ -280,6 +380,44 @@ transfer8x8_copy_c(uint8_t * const dst,
 	}
 }
 
+/*
+ * transfer8x8_copy a word at a time. A misaligned src is read with aligned
+ * loads, the bytes of each row are shifted together from three words.
+ * Needs a word aligned dst and stride, little endian.
+ */
+void
+transfer8x8_copy_swar(uint8_t * const dst,
+					  const uint8_t * const src,
+					  const uint32_t stride)
+{
+	const uint32_t k = (uint32_t)((uintptr_t)src & 3);
+	int j;
+
+	if (((uintptr_t)dst | stride) & 3) {
+		transfer8x8_copy_c(dst, src, stride);
+		return;
+	}
+
+	if (k == 0) {
+		for (j = 0; j < 8; j++) {
+			const u32_alias *s = (const u32_alias *)(src + j * stride);
+			u32_alias *d = (u32_alias *)(dst + j * stride);
+			d[0] = s[0];
+			d[1] = s[1];
+		}
+	} else {
+		const uint32_t right = 8 * k, left = 32 - 8 * k;
+
+		for (j = 0; j < 8; j++) {
+			const u32_alias *s = (const u32_alias *)(src - k + j * stride);
+			u32_alias *d = (u32_alias *)(dst + j * stride);
+			const uint32_t w0 = s[0], w1 = s[1], w2 = s[2];
+			d[0] = (w0 >> right) | (w1 << left);
+			d[1] = (w1 >> right) | (w2 << left);
+		}
+	}
+}
+
 /*
  * SRC - the source buffer
  * DST - the destination buffer
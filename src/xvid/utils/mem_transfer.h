@@ -148,6 +148,26 @@ extern TRANSFER_16TO8ADD_PTR transfer_16to8add;
 extern TRANSFER_16TO8ADD transfer_16to8add_c;
 
 
+/*****************************************************************************
+ * transfer16to8 of a block that is one value everywhere (DC only IDCT)
+ ****************************************************************************/
+
+typedef void (TRANSFER_16TO8DC) (uint8_t * const dst,
+								 const int16_t value,
+								 uint32_t stride);
+
+typedef TRANSFER_16TO8DC *TRANSFER_16TO8DC_PTR;
+
+/* Our global function pointers - Initialized in xvid.c */
+extern TRANSFER_16TO8DC_PTR transfer_16to8copy_dc;
+extern TRANSFER_16TO8DC_PTR transfer_16to8add_dc;
+
+/* Implemented functions */
+extern TRANSFER_16TO8DC transfer_16to8copy_dc_c;
+extern TRANSFER_16TO8DC transfer_16to8add_dc_c;
+extern TRANSFER_16TO8DC transfer_16to8add_dc_swar;
+
+
 /*****************************************************************************
  * transfer8to8 + no op
  ****************************************************************************/
@@ -163,6 +183,7 @@ extern TRANSFER8X8_COPY_PTR transfer8x8_copy;
 
 /* Implemented functions */
 extern TRANSFER8X8_COPY transfer8x8_copy_c;
+extern TRANSFER8X8_COPY transfer8x8_copy_swar;
 
 
 /*****************************************************************************
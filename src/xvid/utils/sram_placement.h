@@ -0,0 +1,26 @@
+/* Generated by tools/sramplan from 15 profiles (245 frames), do not edit.
+ * Regenerate with `make sram-plan`.
+ *
+ * Ordered by accesses per byte and frame, sram_plan_init() places them
+ * in this order as long as they fit. Never accessed, so never placed:
+ * (none)
+ */
+
+static const SRAM_PLACEMENT sram_placement[] = {
+	{SRAM_SCRATCH_DATA, 768, 33902}, /* 44.14 per byte */
+	{SRAM_RGB565, 7168, 131375}, /* 18.33 per byte */
+	{SRAM_SCRATCH_BLOCK, 768, 7765}, /* 10.11 per byte */
+	{SRAM_ROUNDTAB_79, 16, 117}, /* 7.31 per byte */
+	{SRAM_ROUNDTAB_76, 64, 76}, /* 1.18 per byte */
+	{SRAM_QUANT_MATRICES, 1024, 865}, /* 0.84 per byte */
+	{SRAM_TMNMV0, 112, 52}, /* 0.47 per byte */
+	{SRAM_DCT3D_INTER, 2112, 668}, /* 0.32 per byte */
+	{SRAM_QSCALE, 396, 107}, /* 0.27 per byte */
+	{SRAM_DCT3D_INTRA, 2112, 520}, /* 0.25 per byte */
+	{SRAM_CBPY, 512, 61}, /* 0.12 per byte */
+	{SRAM_MCBPC_INTER, 2056, 51}, /* 0.02 per byte */
+	{SRAM_MBS, 96624, 2114}, /* 0.02 per byte */
+	{SRAM_MCBPC_INTRA, 512, 10}, /* 0.02 per byte */
+	{SRAM_TMNMV1, 768, 9}, /* 0.01 per byte */
+	{SRAM_TMNMV2, 1024, 1}, /* 0.00 per byte */
+};
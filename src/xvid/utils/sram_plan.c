@@ -0,0 +1,103 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - SRAM Placement Plan -
+ *
+ *  Copyright(C) 2026
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ ****************************************************************************/
+
+#include "sram_plan.h"
+#include "mem_align.h"
+#include "sram_placement.h"
+
+typedef struct {
+	const char *name;
+	uint32_t blocks; /* allocations that make up the object */
+} SRAM_OBJECT_INFO;
+
+static const SRAM_OBJECT_INFO sram_object_info[SRAM_OBJECTS] = {
+	{"mcbpc_intra", 1},
+	{"mcbpc_inter", 1},
+	{"cbpy", 1},
+	{"tmnmv0", 1},
+	{"tmnmv1", 1},
+	{"tmnmv2", 1},
+	{"roundtab_76", 1},
+	{"roundtab_79", 1},
+	{"dct3d_intra", 1},
+	{"dct3d_inter", 1},
+	{"rgb565", 1},
+	{"quant_matrices", 1},
+	{"scratch_block", 1},
+	{"scratch_data", 1},
+	{"mbs", 2},         /* mbs and last_mbs, they trade places every VOP */
+	{"qscale", 1},
+};
+
+static uint8_t sram_planned[SRAM_OBJECTS];
+static uint32_t sram_largest[SRAM_OBJECTS]; /* largest block allocated */
+static xvid_sram_object_t sram_objects[SRAM_OBJECTS];
+
+#ifdef SRAM_PROFILING
+uint64_t sram_accesses[SRAM_OBJECTS];
+#endif
+
+void
+sram_plan_init(unsigned int pool_size)
+{
+	unsigned int i;
+
+	for (i = 0; i < SRAM_OBJECTS; i++)
+		sram_planned[i] = 0;
+
+	for (i = 0; i < sizeof(sram_placement) / sizeof(sram_placement[0]); i++) {
+		const SRAM_PLACEMENT *p = &sram_placement[i];
+		/* worst case alignment of every block */
+		const uint32_t need = p->bytes + sram_object_info[p->object].blocks * (CACHE_LINE - 1);
+
+		if (p->accesses == 0 || need > pool_size)
+			continue;
+		sram_planned[p->object] = 1;
+		pool_size -= need;
+	}
+}
+
+void *
+xvid_malloc_planned(SRAM_OBJECT object, size_t size, uint8_t alignment)
+{
+	if (size > sram_largest[object])
+		sram_largest[object] = size;
+
+	if (sram_planned[object])
+		return xvid_malloc_sram(size, alignment);
+	return xvid_malloc(size, alignment);
+}
+
+const xvid_sram_object_t *
+sram_plan_objects(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < SRAM_OBJECTS; i++) {
+		sram_objects[i].name = sram_object_info[i].name;
+		sram_objects[i].bytes = sram_largest[i] * sram_object_info[i].blocks;
+		sram_objects[i].in_sram = sram_planned[i];
+#ifdef SRAM_PROFILING
+		sram_objects[i].accesses = sram_accesses[i];
+#else
+		sram_objects[i].accesses = 0;
+#endif
+	}
+	return sram_objects;
+}
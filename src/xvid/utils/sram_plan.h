@@ -0,0 +1,86 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - SRAM Placement Plan Header -
+ *
+ *  Copyright(C) 2026
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ ****************************************************************************/
+
+#ifndef _SRAM_PLAN_H_
+#define _SRAM_PLAN_H_
+
+#include "../portab.h"
+#include "../xvid.h"
+
+/* Everything that may be placed in the SRAM pool. The names in sram_plan.c
+ * are these in lower case without the prefix, profiles and the generated
+ * sram_placement.h refer to the objects by them. */
+typedef enum {
+	SRAM_MCBPC_INTRA,
+	SRAM_MCBPC_INTER,
+	SRAM_CBPY,
+	SRAM_TMNMV0,
+	SRAM_TMNMV1,
+	SRAM_TMNMV2,
+	SRAM_ROUNDTAB_76,
+	SRAM_ROUNDTAB_79,
+	SRAM_DCT3D_INTRA,
+	SRAM_DCT3D_INTER,
+	SRAM_RGB565,
+	SRAM_QUANT_MATRICES,
+	SRAM_SCRATCH_BLOCK,
+	SRAM_SCRATCH_DATA,
+	SRAM_MBS,
+	SRAM_QSCALE,
+	SRAM_OBJECTS
+} SRAM_OBJECT;
+
+/* one entry of the generated sram_placement.h */
+typedef struct {
+	SRAM_OBJECT object;
+	uint32_t bytes;    /* as profiled, all blocks of the object */
+	uint32_t accesses; /* per frame */
+} SRAM_PLACEMENT;
+
+/**
+ * Decide which objects go into a pool of pool_size bytes: in the order of
+ * sram_placement.h, each one that still fits. Called by XVID_GBL_INIT before
+ * anything is allocated, objects the plan leaves out come from the heap.
+ */
+void sram_plan_init(unsigned int pool_size);
+
+/**
+ * Allocate (one block of) an object where the plan put it. SRAM allocations
+ * fall back to the heap like xvid_malloc_sram(), free either with xvid_free().
+ */
+void *xvid_malloc_planned(SRAM_OBJECT object, size_t size, uint8_t alignment);
+
+/**
+ * Name, size, placement and (profiling builds) access count of every object,
+ * SRAM_OBJECTS entries. Points to static storage, refreshed by each call.
+ */
+const xvid_sram_object_t *sram_plan_objects(void);
+
+/* Access counting for the profile sramplan reads. An access is one table
+ * entry or array element read or written, where counting each one would be
+ * in the way the decoder counts whole blocks or macroblocks at once. Only
+ * builds with SRAM_PROFILING count, elsewhere SRAM_COUNT() is empty. */
+#ifdef SRAM_PROFILING
+extern uint64_t sram_accesses[SRAM_OBJECTS];
+#define SRAM_COUNT(object, n) (sram_accesses[object] += (n))
+#else
+#define SRAM_COUNT(object, n) ((void)0)
+#endif
+
+#endif /* _SRAM_PLAN_H_ */
@@ -26,7 +26,8 @@
 /**
  * Initialize all SRAM-backed lookup tables.
  * Must be called after xvid_init_sram() and before decoding.
- * Tables are copied from ROM/SDRAM to fast SRAM.
+ * Tables are copied from ROM/SDRAM to fast SRAM, or to the heap where the
+ * placement plan (sram_plan.h) leaves them out.
  */
 void init_sram_tables(void);
 
@@ -43,19 +44,8 @@ extern VLC *sram_TMNMVtab0;           /* [14] */
 extern VLC *sram_TMNMVtab1;           /* [96] */
 extern VLC *sram_TMNMVtab2;           /* [128] */
 
-/* SRAM-backed DC coefficient tables */
-extern VLC *sram_dcy_tab;             /* [511] */
-extern VLC *sram_dcc_tab;             /* [511] */
-extern VLC *sram_dc_lum_tab;          /* [8] */
-extern short *sram_dc_threshold;      /* [64] */
-
 /* SRAM-backed rounding tables */
-extern uint32_t *sram_roundtab;       /* [16] */
 extern uint32_t *sram_roundtab_76;    /* [16] */
-extern uint32_t *sram_roundtab_78;    /* [8] */
 extern uint32_t *sram_roundtab_79;    /* [4] */
 
-/* SRAM-backed zigzag scan tables */
-extern uint16_t *sram_scan_tables;    /* [3][64] = 192 */
-
 #endif /* _SRAM_TABLES_H_ */
@@ -51,13 +51,17 @@
 
 #include "xvid.h"
 #include "decoder.h"
+#ifndef XVID_DECODER_ONLY
 #include "encoder.h"
+#endif
 #include "bitstream/cbp.h"
 #include "dct/idct.h"
 #include "dct/fdct.h"
 #include "image/colorspace.h"
 #include "image/interpolate8x8.h"
 #include "utils/mem_align.h"
+#include "utils/sram_tables.h"
+#include "utils/sram_plan.h"
 #include "utils/mem_transfer.h"
 #include "utils/mbfunctions.h"
 #include "quant/quant.h"
@@ -113,18 +117,27 @@ int xvid_gbl_init(xvid_gbl_init_t * init)
 
 	if (init->sram_base && init->sram_size > 0) {
 		xvid_init_sram(init->sram_base, init->sram_size);
+		sram_plan_init(init->sram_size);
 	}
 
 	/* Initialize the function pointers */
 	init_vlc_tables();
+	/* the global SRAM tables go below every decoder's blocks, so those can be
+	 * given back to the pool when the decoder goes */
+	init_sram_tables();
 
 	/* Fixed Point Forward/Inverse DCT transformations */
+#ifndef XVID_DECODER_ONLY
 	fdct = fdct_int32;
+#endif
 	// idct = idct_int32;
 	idct = simple_idct_c;
+	/* the decoder uses the fused simple_idct_add_c/simple_idct_put_c, exact with simple_idct_c only */
 
+#ifndef XVID_DECODER_ONLY
 	/* Only needed on PPC Altivec archs */
 	sadInit = NULL;
+#endif
 
 	/* Restore FPU context : emms_c is a nop functions */
 	emms = emms_c;
@@ -134,7 +147,8 @@ int xvid_gbl_init(xvid_gbl_init_t * init)
 	xvid_QP_Add_Funcs = &xvid_QP_Add_Funcs_C;
 	xvid_Init_QP();
 
-	/* Quantization functions */
+#ifndef XVID_DECODER_ONLY
+	/* Quantization functions, the decoder dequantizes while parsing */
 	quant_h263_intra   = quant_h263_intra_c;
 	quant_h263_inter   = quant_h263_inter_c;
 	dequant_h263_intra = dequant_h263_intra_c;
@@ -144,6 +158,7 @@ int xvid_gbl_init(xvid_gbl_init_t * init)
 	quant_mpeg_inter   = quant_mpeg_inter_c;
 	dequant_mpeg_intra = dequant_mpeg_intra_c;
 	dequant_mpeg_inter = dequant_mpeg_inter_c;
+#endif
 
 	/* Block transfer related functions */
 	transfer_8to16copy = transfer_8to16copy_c;
@@ -153,11 +168,15 @@ int xvid_gbl_init(xvid_gbl_init_t * init)
 	transfer_8to16sub2 = transfer_8to16sub2_c;
 	transfer_8to16sub2ro = transfer_8to16sub2ro_c;
 	transfer_16to8add  = transfer_16to8add_c;
-	transfer8x8_copy   = transfer8x8_copy_c;
+	transfer_16to8copy_dc = transfer_16to8copy_dc_c;
+	transfer_16to8add_dc  = transfer_16to8add_dc_swar;
+	transfer8x8_copy   = transfer8x8_copy_swar;
 	transfer8x4_copy   = transfer8x4_copy_c;
 
+#ifndef XVID_DECODER_ONLY
 	/* Interlacing functions */
 	MBFieldTest = MBFieldTest_c;
+#endif
 
 	/* Image interpolation related functions */
 	interpolate8x8_halfpel_h  = interpolate8x8_halfpel_h_c;
@@ -239,6 +258,7 @@ int xvid_gbl_init(xvid_gbl_init_t * init)
 	yv12_to_yuyvi   = yv12_to_yuyvi_c;
 	yv12_to_uyvyi   = yv12_to_uyvyi_c;
 
+#ifndef XVID_DECODER_ONLY
 	/* Functions used in motion estimation algorithms */
 	calc_cbp      = calc_cbp_c;
 	sad16         = sad16_c;
@@ -253,6 +273,7 @@ int xvid_gbl_init(xvid_gbl_init_t * init)
 	sseh8_16bit   = sseh8_16bit_c;
 	coeff8_energy = coeff8_energy_c;
 	blocksum8     = blocksum8_c;
+#endif
 
 	init_GMC(cpu_flags);
 
@@ -371,6 +392,19 @@ xvid_gbl_convert(xvid_gbl_convert_t* convert)
 	return 0;
 }
 
+static int
+xvid_gbl_sram(xvid_gbl_sram_t* sram)
+{
+	if (XVID_VERSION_MAJOR(sram->version) != 1) /* v1.x.x */
+		return XVID_ERR_VERSION;
+
+	xvid_sram_stats(&sram->size, &sram->used, &sram->peak,
+					&sram->spills, &sram->spilled_bytes);
+	sram->num_objects = SRAM_OBJECTS;
+	sram->objects = sram_plan_objects();
+	return 0;
+}
+
 /*****************************************************************************
  * Xvid Global Entry point
  *
@@ -399,6 +433,9 @@ xvid_global(void *handle,
 		case XVID_GBL_CONVERT :
 			return xvid_gbl_convert((xvid_gbl_convert_t*)param1);
 
+		case XVID_GBL_SRAM :
+			return xvid_gbl_sram((xvid_gbl_sram_t*)param1);
+
 		default :
 			return XVID_ERR_FAIL;
 	}
@@ -436,6 +473,8 @@ xvid_decore(void *handle,
 }
 
 
+#ifndef XVID_DECODER_ONLY
+
 /*****************************************************************************
  * Xvid Native encoder entry point
  *
@@ -469,3 +508,5 @@ xvid_encore(void *handle,
 		return XVID_ERR_FAIL;
 	}
 }
+
+#endif /* !XVID_DECODER_ONLY */
@@ -111,6 +111,7 @@ extern "C" {
 #define XVID_CSP_SLICE    (1<<12) /* decoder only: 4:2:0 planar, per slice rendering */
 #define XVID_CSP_INTERNAL (1<<13) /* decoder only: 4:2:0 planar, returns ptrs to internal buffers */
 #define XVID_CSP_NULL     (1<<14) /* decoder only: dont output anything */
+#define XVID_CSP_ROTATE   (1<<30) /* rgb565 only: rotate 90 degrees clockwise, output is height pixels wide */
 #define XVID_CSP_VFLIP    (1<<31) /* vertical flip mask */
 
 /* xvid_image_t
@@ -221,9 +222,31 @@ typedef struct {
 } xvid_gbl_convert_t;
 
 
+/* XVID_GBL_SRAM: one buffer or table of the SRAM placement plan */
+typedef struct {
+	const char *name;            /* [out] as in profiles and sram_placement.h */
+	unsigned int bytes;          /* [out] largest allocation so far times its blocks, 0 = not allocated */
+	int in_sram;                 /* [out] the plan places it in the SRAM pool */
+	unsigned long long accesses; /* [out] counted accesses, builds with SRAM_PROFILING only */
+} xvid_sram_object_t;
+
+/* XVID_GBL_SRAM param1 */
+typedef struct {
+	int version;
+	unsigned int size;          /* [out] SRAM pool size given to XVID_GBL_INIT, 0 = none */
+	unsigned int used;          /* [out] bytes of the pool in use now */
+	unsigned int peak;          /* [out] most bytes of the pool ever in use */
+	unsigned int spills;        /* [out] allocations that did not fit and went to the heap */
+	unsigned int spilled_bytes; /* [out] total size of those allocations */
+	int num_objects;                    /* [out] number of entries in objects */
+	const xvid_sram_object_t *objects;  /* [out] the placement plan, valid until the next call */
+} xvid_gbl_sram_t;
+
+
 #define XVID_GBL_INIT    0 /* initialize xvidcore; must be called before using xvid_decore, or xvid_encore) */
 #define XVID_GBL_INFO    1 /* return some info about xvidcore, and the host computer */
 #define XVID_GBL_CONVERT 2 /* colorspace conversion utility */
+#define XVID_GBL_SRAM    3 /* SRAM pool usage */
 
 extern int xvid_global(void *handle, int opt, void *param1, void *param2);
 
@@ -262,9 +285,10 @@ typedef struct {
 #define XVID_DERINGUV      (1<<5) /* perform chroma deringing, requires deblocking to work */
 #define XVID_DERINGY       (1<<6) /* perform luma deringing, requires deblocking to work */
 
+#define XVID_DEC_REPEAT    (1<<28) /* don't write output for a picture that repeats the previous one, see XVID_VOP_REPEAT */
 #define XVID_DEC_FAST      (1<<29) /* disable postprocessing to decrease cpu usage *todo* */
-#define XVID_DEC_DROP      (1<<30) /* drop bframes to decrease cpu usage *todo* */
-#define XVID_DEC_PREROLL   (1<<31) /* decode as fast as you can, don't even show output *todo* */
+#define XVID_DEC_DROP      (1<<30) /* drop bframes to decrease cpu usage: b-vops are parsed only, nothing is output */
+#define XVID_DEC_PREROLL   (1<<31) /* decode as fast as you can, don't even show output */
 
 typedef struct {
 	int version;
@@ -672,6 +696,9 @@ extern int xvid_encore(void *handle, int opt, void *param1, void *param2);
 #define XVID_VOP_RD_BVOP              (1<<13) /* enable rate-distortion mode decision in b-frames */
 #define XVID_VOP_RD_PSNRHVSM          (1<<14) /* use PSNR-HVS-M as metric for rate-distortion optimizations */
 
+/* decoder only, xvid_dec_stats_t.data.vop.general */
+#define XVID_VOP_REPEAT               (1<<15) /* same picture as the previous output (N-VOP, no coded macroblock) */
+
 /* Only valid for vol_flags|=XVID_VOL_INTERLACING */
 #define XVID_VOP_TOPFIELDFIRST        (1<< 9) /* set top-field-first flag  */
 #define XVID_VOP_ALTERNATESCAN        (1<<10) /* set alternate vertical scan flag */
@@ -0,0 +1,478 @@
+// Golden-output conformance runner for the xvid decoder.
+//
+// Decodes every clip with xvid_decore(XVID_DEC_DECODE) and compares a hash of
+// each output picture against tests/conformance/<clip>.golden. Two hashes are
+// kept per frame: the visible YV12 planes (catches IDCT, MC, VLC and dequant
+// changes) and the RGB565 conversion of the same picture (catches colorspace
+// changes). The RGB565 conversion with XVID_CSP_ROTATE is checked against the
+// plain conversion turned 90 degrees clockwise. The golden values were produced by the plain C kernels
+// (simple_idct_c, interpolate8x8_*_c, ...), any optimized path must reproduce
+// them bit-exactly.
+//
+// Every clip is decoded a second time with XVID_DEC_DROP, the B-VOPs are then
+// only parsed and every other picture must still match, otherwise dropping a
+// B-VOP disturbed the reference frames or the bitstream position.
+//
+// With XVID_DEC_REPEAT the decoder leaves out pictures that repeat the
+// previous output (N-VOPs, P-VOPs without a coded macroblock), the previous
+// picture's hashes stand in for them and have to match as well.
+//
+// Finally the RGB565 output with XVID_CSP_SLICE (converted per macroblock row
+// while decoding) must equal the whole-picture conversion, plain and rotated,
+// with and without deblocking and deringing.
+//
+// The reader may look at FILE_READ_BUFFER_PADDING bytes behind the data, but
+// must not depend on them: the padding repeats the clip's last bytes instead of
+// being zero and ends the heap block, so ASan builds catch reads beyond it. The
+// stuffing clips end in macroblock stuffing that the padding continues.
+//
+// The decoders draw on a simulated SRAM pool like on the calculator, after
+// every clip all of it except the global tables must be back in the pool.
+//
+// Usage: conformance [-update] <clip.m4v>...
+//   -update   (re)write the .golden files instead of comparing
+
+#include <xvid.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define FILE_READ_BUFFER_PADDING 32
+#define PADDING_PERIOD 45 // whole 9 and 10 bit stuffing codes
+#define SRAM_POOL_SIZE (256 * 1024)
+#define SIZEOF_RGB565 2
+
+namespace {
+
+struct FrameHash {
+    int index;
+    char type;
+    uint64_t yv12;
+    uint64_t rgb565;
+    bool rotatedMatches = true; // not stored in the golden file, the reference is the unrotated conversion
+    bool repeated = false; // XVID_DEC_REPEAT: copied from the previous picture, not compared
+
+    bool operator==(const FrameHash& other) const {
+        return this->type == other.type && this->yv12 == other.yv12 && this->rgb565 == other.rgb565 &&
+               this->rotatedMatches == other.rotatedMatches;
+    }
+};
+
+// FNV-1a, 64 bit
+uint64_t HashBytes(uint64_t hash, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+constexpr uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+uint64_t HashPlane(uint64_t hash, const void* plane, int stride, int width, int height) {
+    const uint8_t* row = static_cast<const uint8_t*>(plane);
+    for (int y = 0; y < height; y++, row += stride) {
+        hash = HashBytes(hash, row, width);
+    }
+    return hash;
+}
+
+char TypeChar(int type) {
+    switch (type)
+    {
+    case XVID_TYPE_IVOP: return 'I';
+    case XVID_TYPE_PVOP: return 'P';
+    case XVID_TYPE_BVOP: return 'B';
+    case XVID_TYPE_SVOP: return 'S';
+    case 5 /* internal nvop type */: return 'N';
+    default: return '?';
+    }
+}
+
+bool ReadWholeFile(const std::string& filename, std::vector<uint8_t>& out) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string GoldenPathFor(const std::string& clipPath) {
+    const size_t dot = clipPath.rfind('.');
+    const size_t slash = clipPath.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return clipPath + ".golden";
+    }
+    return clipPath.substr(0, dot) + ".golden";
+}
+
+// Hashes the picture the decoder just returned in XVID_CSP_INTERNAL form.
+FrameHash HashOutput(int index, int type, const xvid_dec_frame_t& decFrame, int width, int height,
+                     std::vector<uint8_t>& rgbBuffer) {
+    FrameHash h{index, TypeChar(type), HashSeed, HashSeed};
+
+    h.yv12 = HashPlane(h.yv12, decFrame.output.plane[0], decFrame.output.stride[0], width, height);
+    h.yv12 = HashPlane(h.yv12, decFrame.output.plane[1], decFrame.output.stride[1], width / 2, height / 2);
+    h.yv12 = HashPlane(h.yv12, decFrame.output.plane[2], decFrame.output.stride[2], width / 2, height / 2);
+
+    rgbBuffer.resize((size_t)width * height * SIZEOF_RGB565);
+    xvid_gbl_convert_t convert{};
+    convert.version = XVID_VERSION;
+    convert.input = decFrame.output;
+    convert.input.csp = XVID_CSP_INTERNAL;
+    convert.output.csp = XVID_CSP_RGB565;
+    convert.output.plane[0] = rgbBuffer.data();
+    convert.output.stride[0] = width * SIZEOF_RGB565;
+    convert.width = width;
+    convert.height = height;
+    if (xvid_global(NULL, XVID_GBL_CONVERT, &convert, NULL) == 0) {
+        h.rgb565 = HashBytes(h.rgb565, rgbBuffer.data(), rgbBuffer.size());
+    }
+
+    // rotated output is height pixels wide, source pixel (x, y) goes to row x, column height-1-y
+    std::vector<uint16_t> rotated((size_t)width * height);
+    convert.output.csp = XVID_CSP_RGB565 | XVID_CSP_ROTATE;
+    convert.output.plane[0] = rotated.data();
+    convert.output.stride[0] = height * SIZEOF_RGB565;
+    if (xvid_global(NULL, XVID_GBL_CONVERT, &convert, NULL) == 0) {
+        for (int y = 0; y < height && h.rotatedMatches; y++) {
+            for (int x = 0; x < width; x++) {
+                uint16_t pixel;
+                memcpy(&pixel, &rgbBuffer[((size_t)y * width + x) * SIZEOF_RGB565], sizeof(pixel));
+                if (rotated[(size_t)x * height + (height - 1 - y)] != pixel) {
+                    h.rotatedMatches = false;
+                    break;
+                }
+            }
+        }
+    }
+    return h;
+}
+
+// Returns an empty string on success, an error message otherwise.
+// csp XVID_CSP_INTERNAL hashes both forms through HashOutput, any RGB565 csp
+// is decoded straight into a buffer and only the rgb565 hash is filled in.
+std::string DecodeClip(const std::string& path, int general, int csp, std::vector<FrameHash>& frames, int& width, int& height) {
+    std::vector<uint8_t> data;
+    if (!ReadWholeFile(path, data)) {
+        return "cannot read " + path;
+    }
+    const size_t length = data.size();
+    std::unique_ptr<uint8_t[]> input(new uint8_t[length + FILE_READ_BUFFER_PADDING]);
+    std::copy(data.begin(), data.end(), input.get());
+    for (size_t i = 0; i < FILE_READ_BUFFER_PADDING; i++) {
+        input[length + i] = length >= PADDING_PERIOD ? data[length - PADDING_PERIOD + i % PADDING_PERIOD] : 0;
+    }
+
+    xvid_dec_create_t xvid_dec_create{};
+    xvid_dec_create.version = XVID_VERSION;
+    if (xvid_decore(NULL, XVID_DEC_CREATE, &xvid_dec_create, NULL) < 0) {
+        return "failed to create decoder";
+    }
+    void* handle = xvid_dec_create.handle;
+
+    std::vector<uint8_t> rgbBuffer;
+    std::vector<uint8_t> outBuffer;
+    std::string error;
+    size_t readHead = 0;
+    size_t readAvailable = length;
+    bool hadDiscontinuity = true;
+    bool flushed = false;
+
+    while (!flushed) {
+        xvid_dec_frame_t decFrame{};
+        decFrame.version = XVID_VERSION;
+        decFrame.general = general | (hadDiscontinuity ? XVID_DISCONTINUITY : 0);
+        // plane pointers are filled in by the decoder, but it only outputs
+        // when handed a non-null plane with a large enough stride
+        static uint8_t internalPlaceholder;
+        decFrame.output.csp = csp;
+        if (csp == XVID_CSP_INTERNAL) {
+            decFrame.output.plane[0] = &internalPlaceholder;
+            decFrame.output.stride[0] = width;
+        } else {
+            // before the VOL header the size is unknown, the stride of 0 keeps the decoder from writing
+            outBuffer.assign((size_t)width * height * SIZEOF_RGB565, 0);
+            decFrame.output.plane[0] = outBuffer.data() ? outBuffer.data() : &internalPlaceholder;
+            decFrame.output.stride[0] = ((csp & XVID_CSP_ROTATE) ? height : width) * SIZEOF_RGB565;
+        }
+        if (readAvailable > 0) {
+            decFrame.bitstream = input.get() + readHead;
+            decFrame.length = (int)readAvailable;
+        } else {
+            // end of stream, get the last reference frame out of the decoder
+            decFrame.bitstream = NULL;
+            decFrame.length = -1;
+            flushed = true;
+        }
+
+        xvid_dec_stats_t decStats{};
+        decStats.version = XVID_VERSION;
+
+        const int bytesConsumed = xvid_decore(handle, XVID_DEC_DECODE, &decFrame, &decStats);
+        if (bytesConsumed == XVID_ERR_END) {
+            break;
+        }
+        if (bytesConsumed < 0) {
+            error = "decode error " + std::to_string(bytesConsumed) + " at offset " + std::to_string(readHead);
+            break;
+        }
+        hadDiscontinuity = false;
+
+        if (decStats.type == XVID_TYPE_VOL) {
+            width = decStats.data.vol.width;
+            height = decStats.data.vol.height;
+        } else if (decStats.type > 0 && (decStats.data.vop.general & XVID_VOP_REPEAT) &&
+                   (general & XVID_DEC_REPEAT) && !frames.empty()) {
+            // nothing was written, the caller shows the previous picture again
+            FrameHash h = frames.back();
+            h.index = (int)frames.size();
+            h.type = TypeChar(decStats.type);
+            h.repeated = true;
+            frames.push_back(h);
+        } else if (decStats.type == XVID_TYPE_BVOP && (general & XVID_DEC_DROP)) {
+            // parsed only, there is no picture to hash
+            frames.push_back(FrameHash{(int)frames.size(), TypeChar(decStats.type), 0, 0});
+        } else if (decStats.type > 0 && csp == XVID_CSP_INTERNAL) {
+            frames.push_back(HashOutput((int)frames.size(), decStats.type, decFrame, width, height, rgbBuffer));
+        } else if (decStats.type > 0) {
+            frames.push_back(FrameHash{(int)frames.size(), TypeChar(decStats.type), 0,
+                                       HashBytes(HashSeed, outBuffer.data(), outBuffer.size())});
+        }
+
+        if (!flushed) {
+            if (bytesConsumed == 0 || (size_t)bytesConsumed > readAvailable) {
+                readAvailable = 0;
+            } else {
+                readHead += bytesConsumed;
+                readAvailable -= bytesConsumed;
+            }
+        }
+    }
+
+    xvid_decore(handle, XVID_DEC_DESTROY, NULL, NULL);
+    return error;
+}
+
+// XVID_DEC_REPEAT output against the golden hashes, repeated pictures included.
+bool CheckRepeatOutput(const std::string& clip, const std::vector<FrameHash>& golden) {
+    std::vector<FrameHash> frames;
+    int width = 0, height = 0;
+    const std::string error = DecodeClip(clip, XVID_DEC_REPEAT, XVID_CSP_INTERNAL, frames, width, height);
+    size_t mismatches = 0;
+    for (size_t i = 0; error.empty() && i < std::max(golden.size(), frames.size()); i++) {
+        if (i >= golden.size() || i >= frames.size() || !(golden[i] == frames[i])) {
+            mismatches++;
+        }
+    }
+    if (!error.empty() || mismatches) {
+        printf("FAIL %s: with XVID_DEC_REPEAT: %s\n", clip.c_str(),
+               error.empty() ? (std::to_string(mismatches) + " frames differ").c_str() : error.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Row-by-row RGB565 output against the whole-picture conversion.
+bool CheckSliceOutput(const std::string& clip) {
+    constexpr int postproc = XVID_DEBLOCKY | XVID_DEBLOCKUV | XVID_DERINGY | XVID_DERINGUV;
+    for (int csp : {XVID_CSP_RGB565, XVID_CSP_RGB565 | XVID_CSP_ROTATE}) {
+        for (int general : {0, postproc}) {
+            std::vector<FrameHash> whole, rows;
+            int width = 0, height = 0;
+            std::string error = DecodeClip(clip, general, csp, whole, width, height);
+            if (error.empty()) {
+                error = DecodeClip(clip, general, csp | XVID_CSP_SLICE, rows, width, height);
+            }
+            size_t mismatches = 0;
+            for (size_t i = 0; error.empty() && i < std::max(whole.size(), rows.size()); i++) {
+                if (i >= whole.size() || i >= rows.size() || !(whole[i] == rows[i])) {
+                    mismatches++;
+                }
+            }
+            if (!error.empty() || mismatches) {
+                printf("FAIL %s: XVID_CSP_SLICE output%s%s: %s\n", clip.c_str(),
+                       (csp & XVID_CSP_ROTATE) ? " rotated" : "", general ? " with postprocessing" : "",
+                       error.empty() ? (std::to_string(mismatches) + " frames differ").c_str() : error.c_str());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::string FormatHash(const FrameHash& h) {
+    char line[64];
+    snprintf(line, sizeof(line), "%d %c %016llx %016llx", h.index, h.type,
+        (unsigned long long)h.yv12, (unsigned long long)h.rgb565);
+    return line;
+}
+
+bool WriteGolden(const std::string& path, const std::string& clip, int width, int height,
+                 const std::vector<FrameHash>& frames) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "# " << clip << " " << width << "x" << height << "\n";
+    out << "# frame type yv12 rgb565 (FNV-1a 64 of the visible picture)\n";
+    for (const FrameHash& h : frames) {
+        out << FormatHash(h) << "\n";
+    }
+    return true;
+}
+
+bool ReadGolden(const std::string& path, std::vector<FrameHash>& frames) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        FrameHash h{};
+        unsigned long long yv12 = 0, rgb565 = 0;
+        if (sscanf(line.c_str(), "%d %c %llx %llx", &h.index, &h.type, &yv12, &rgb565) != 4) {
+            return false;
+        }
+        h.yv12 = yv12;
+        h.rgb565 = rgb565;
+        frames.push_back(h);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool update = false;
+    std::vector<std::string> clips;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-update") == 0) {
+            update = true;
+        } else {
+            clips.push_back(argv[i]);
+        }
+    }
+    if (clips.empty()) {
+        fputs("Usage: conformance [-update] <clip.m4v>...\n", stderr);
+        return 2;
+    }
+
+    static uint8_t sramPool[SRAM_POOL_SIZE];
+    xvid_gbl_init_t xvid_gbl_init{};
+    xvid_gbl_init.version = XVID_VERSION;
+    xvid_gbl_init.sram_base = sramPool;
+    xvid_gbl_init.sram_size = sizeof(sramPool);
+    if (xvid_global(NULL, XVID_GBL_INIT, &xvid_gbl_init, NULL) < 0) {
+        fputs("conformance: xvid_global(XVID_GBL_INIT) failed\n", stderr);
+        return 1;
+    }
+
+    xvid_gbl_sram_t sram{};
+    sram.version = XVID_VERSION;
+    xvid_global(NULL, XVID_GBL_SRAM, &sram, NULL);
+    const unsigned int sramGlobal = sram.used;
+
+    int failures = 0;
+    for (const std::string& clip : clips) {
+        const std::string goldenPath = GoldenPathFor(clip);
+        std::vector<FrameHash> frames;
+        int width = 0, height = 0;
+
+        const std::string error = DecodeClip(clip, 0, XVID_CSP_INTERNAL, frames, width, height);
+        if (!error.empty()) {
+            printf("FAIL %s: %s\n", clip.c_str(), error.c_str());
+            failures++;
+            continue;
+        }
+
+        std::string types;
+        for (const FrameHash& h : frames) {
+            types += h.type;
+        }
+
+        if (update) {
+            if (!WriteGolden(goldenPath, clip.substr(clip.rfind('/') + 1), width, height, frames)) {
+                printf("FAIL %s: cannot write %s\n", clip.c_str(), goldenPath.c_str());
+                failures++;
+                continue;
+            }
+            printf("UPDATED %s (%zu frames %s)\n", clip.c_str(), frames.size(), types.c_str());
+            continue;
+        }
+
+        std::vector<FrameHash> golden;
+        if (!ReadGolden(goldenPath, golden)) {
+            printf("FAIL %s: missing or malformed %s\n", clip.c_str(), goldenPath.c_str());
+            failures++;
+            continue;
+        }
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < std::max(golden.size(), frames.size()); i++) {
+            if (i < golden.size() && i < frames.size() && golden[i] == frames[i]) {
+                continue;
+            }
+            if (mismatches++ < 3) {
+                printf("  frame %zu: expected %s\n", i, i < golden.size() ? FormatHash(golden[i]).c_str() : "(none)");
+                printf("  frame %zu: got      %s\n", i, i < frames.size() ? FormatHash(frames[i]).c_str() : "(none)");
+                if (i < frames.size() && !frames[i].rotatedMatches) {
+                    printf("  frame %zu: rotated RGB565 output differs from the rotated picture\n", i);
+                }
+            }
+        }
+        if (mismatches) {
+            printf("FAIL %s: %zu of %zu frames differ\n", clip.c_str(), mismatches, golden.size());
+            failures++;
+            continue;
+        }
+
+        std::vector<FrameHash> dropped;
+        const std::string dropError = DecodeClip(clip, XVID_DEC_DROP, XVID_CSP_INTERNAL, dropped, width, height);
+        size_t dropMismatches = 0;
+        for (size_t i = 0; dropError.empty() && i < std::max(golden.size(), dropped.size()); i++) {
+            if (i < golden.size() && i < dropped.size() &&
+                (golden[i].type == 'B' ? dropped[i].type == 'B' : golden[i] == dropped[i])) {
+                continue;
+            }
+            if (dropMismatches++ < 3) {
+                printf("  frame %zu: expected %s\n", i, i < golden.size() ? FormatHash(golden[i]).c_str() : "(none)");
+                printf("  frame %zu: dropped  %s\n", i, i < dropped.size() ? FormatHash(dropped[i]).c_str() : "(none)");
+            }
+        }
+        if (!dropError.empty()) {
+            printf("FAIL %s: with XVID_DEC_DROP: %s\n", clip.c_str(), dropError.c_str());
+            failures++;
+        } else if (dropMismatches) {
+            printf("FAIL %s: with XVID_DEC_DROP %zu of %zu frames differ\n", clip.c_str(), dropMismatches, golden.size());
+            failures++;
+        } else if (!CheckRepeatOutput(clip, golden)) {
+            failures++;
+        } else if (!CheckSliceOutput(clip)) {
+            failures++;
+        } else if (xvid_global(NULL, XVID_GBL_SRAM, &sram, NULL) < 0 || sram.used != sramGlobal) {
+            printf("FAIL %s: %u SRAM bytes still in use after the decoders, %u expected\n",
+                   clip.c_str(), sram.used, sramGlobal);
+            failures++;
+        } else {
+            printf("PASS %s (%zu frames %s)\n", clip.c_str(), frames.size(), types.c_str());
+        }
+    }
+
+    xvid_global(NULL, XVID_GBL_SRAM, &sram, NULL);
+    printf("SRAM: %u bytes peak of %u, %u allocations (%u bytes) spilled\n",
+           sram.peak, sram.size, sram.spills, sram.spilled_bytes);
+    printf("%d of %zu clips failed\n", failures, clips.size());
+    return failures ? 1 : 0;
+}
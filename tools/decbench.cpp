@@ -0,0 +1,349 @@
+// Host-side decode benchmark for the xvid decoder core.
+//
+// Decodes a raw .m4v elementary stream (the same files the player takes) into
+// XVID_CSP_INTERNAL and reports per-VOP-type decode times in the same
+// min/Q1/med/Q3/max format as VideoPlayer::dumpState(), so kernel changes can
+// be compared off-device before touching the calculator.
+//
+// Build with `make host`, run as `build/host/decbench video.m4v [options]`.
+//
+// Built with -DSRAM_PROFILING (`make sram-plan` does that) it can also write
+// the SRAM access profile tools/sramplan turns into sram_placement.h.
+
+#include <xvid.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "../src/videoplayer/Statistics.hpp"
+
+// Same padding the player keeps behind its read buffer, the bitstream reader
+// may look a few bytes past the end of the data it was handed.
+#define FILE_READ_BUFFER_PADDING 32
+
+#define SIZEOF_RGB565 2
+
+namespace {
+
+struct BenchOptions {
+    std::string filename;
+    int loops = 1;
+    int maxFrames = 0; // 0 = whole file
+    bool convertRGB565 = false;
+    std::string sramProfile; // empty = don't write one
+
+    // player defaults
+    bool fastDecoding = true;
+    bool lowDelayMode = false;
+    bool deblockLuma = false;
+    bool deblockChroma = false;
+    bool deringLuma = false;
+    bool deringChroma = false;
+};
+
+struct BenchTimes {
+    std::vector<uint32_t> IFrame_DecodeTimes;
+    std::vector<uint32_t> PFrame_DecodeTimes;
+    std::vector<uint32_t> BFrame_DecodeTimes;
+    std::vector<uint32_t> SFrame_DecodeTimes;
+    std::vector<uint32_t> NFrame_DecodeTimes;
+
+    // calls that consumed data without producing a picture (VOL headers, B-frame pipeline fill)
+    std::vector<uint32_t> WastedFrame_DecodeTimes;
+
+    uint64_t totalNanoseconds = 0;
+};
+
+uint64_t NowNanoseconds() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1'000'000'000ull + (uint64_t)ts.tv_nsec;
+}
+
+bool ReadWholeFile(const std::string& filename, std::vector<uint8_t>& out) {
+    FILE* f = fopen(filename.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    out.clear();
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        out.insert(out.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+std::string GetXvidErrorMessage(int errorCode) {
+    switch (errorCode)
+    {
+    case XVID_ERR_FAIL:
+        return "Generic failure (XVID_ERR_FAIL)";
+    case XVID_ERR_MEMORY:
+        return "Allocation failed (XVID_ERR_MEMORY)";
+    case XVID_ERR_FORMAT:
+        return "Invalid bitstream format (XVID_ERR_FORMAT)";
+    case XVID_ERR_VERSION:
+        return "Version mismatch (XVID_ERR_VERSION)";
+    case XVID_ERR_END:
+        return "End of stream reached (XVID_ERR_END)";
+    default:
+        return "Unknown error";
+    }
+}
+
+// Decodes the whole stream once with a fresh decoder instance.
+// Returns an empty string on success, an error message otherwise.
+std::string DecodeOnce(
+    const BenchOptions& options,
+    const uint8_t* data,
+    size_t length,
+    BenchTimes& times,
+    int& width,
+    int& height
+) {
+    xvid_dec_create_t xvid_dec_create{};
+    xvid_dec_create.version = XVID_VERSION;
+    if (xvid_decore(NULL, XVID_DEC_CREATE, &xvid_dec_create, NULL) < 0) {
+        return "Failed to create Xvid decoder";
+    }
+    void* handle = xvid_dec_create.handle;
+
+    std::vector<uint8_t> rgbBuffer;
+    std::string error;
+
+    size_t readHead = 0;
+    size_t readAvailable = length;
+    bool hadDiscontinuity = true; // first call, like VideoPlayer::readVOLHeader()
+    int framesOut = 0;
+
+    const uint64_t loopStart = NowNanoseconds();
+    while (readAvailable > 0 && (options.maxFrames == 0 || framesOut < options.maxFrames)) {
+        xvid_dec_frame_t decFrame{};
+        decFrame.version = XVID_VERSION;
+        decFrame.general =
+            (options.fastDecoding ? XVID_DEC_FAST : 0) |
+            (options.lowDelayMode ? XVID_LOWDELAY : 0) |
+            (options.deblockLuma ? XVID_DEBLOCKY : 0) |
+            (options.deblockChroma ? XVID_DEBLOCKUV : 0) |
+            (options.deringLuma ? XVID_DERINGY : 0) |
+            (options.deringChroma ? XVID_DERINGUV : 0) |
+            (hadDiscontinuity ? XVID_DISCONTINUITY : 0);
+        decFrame.bitstream = (void*)(data + readHead);
+        decFrame.length = (int)readAvailable;
+
+        if (options.convertRGB565 && width > 0) {
+            rgbBuffer.resize((size_t)width * height * SIZEOF_RGB565);
+            decFrame.output.csp = XVID_CSP_RGB565;
+            decFrame.output.plane[0] = rgbBuffer.data();
+            decFrame.output.stride[0] = width * SIZEOF_RGB565;
+        } else {
+            // plane pointers are filled in by the decoder, but it only outputs
+            // when handed a non-null plane with a large enough stride
+            static uint8_t internalPlaceholder;
+            decFrame.output.csp = XVID_CSP_INTERNAL;
+            decFrame.output.plane[0] = &internalPlaceholder;
+            decFrame.output.stride[0] = width;
+        }
+
+        xvid_dec_stats_t decStats{};
+        decStats.version = XVID_VERSION;
+
+        const uint64_t frameDecodeStart = NowNanoseconds();
+        const int bytesConsumed = xvid_decore(handle, XVID_DEC_DECODE, &decFrame, &decStats);
+        const uint32_t elapsed = (uint32_t)(NowNanoseconds() - frameDecodeStart);
+
+        if (bytesConsumed < 0) {
+            error = "Failed to decode frame: " + GetXvidErrorMessage(bytesConsumed);
+            break;
+        }
+        if (bytesConsumed == 0 || (size_t)bytesConsumed > readAvailable) {
+            // trailing garbage or a truncated last frame, nothing more to decode
+            break;
+        }
+        hadDiscontinuity = false;
+
+        switch (decStats.type)
+        {
+        case XVID_TYPE_VOL:
+            width = decStats.data.vol.width;
+            height = decStats.data.vol.height;
+            times.WastedFrame_DecodeTimes.push_back(elapsed);
+            break;
+        case XVID_TYPE_IVOP: times.IFrame_DecodeTimes.push_back(elapsed); framesOut++; break;
+        case XVID_TYPE_PVOP: times.PFrame_DecodeTimes.push_back(elapsed); framesOut++; break;
+        case XVID_TYPE_BVOP: times.BFrame_DecodeTimes.push_back(elapsed); framesOut++; break;
+        case XVID_TYPE_SVOP: times.SFrame_DecodeTimes.push_back(elapsed); framesOut++; break;
+        case 5 /* internal nvop type */: times.NFrame_DecodeTimes.push_back(elapsed); break;
+        default:
+            times.WastedFrame_DecodeTimes.push_back(elapsed);
+            break;
+        }
+
+        readHead += bytesConsumed;
+        readAvailable -= bytesConsumed;
+    }
+    times.totalNanoseconds += NowNanoseconds() - loopStart;
+
+    xvid_decore(handle, XVID_DEC_DESTROY, NULL, NULL);
+    return error;
+}
+
+// One line per SRAM object: name, bytes, accesses. sramplan adds up several
+// of these, the frame count weights them.
+bool WriteSramProfile(const std::string& path, const std::string& clip, size_t frames) {
+    xvid_gbl_sram_t sram{};
+    sram.version = XVID_VERSION;
+    if (xvid_global(NULL, XVID_GBL_SRAM, &sram, NULL) < 0) {
+        fputs("decbench: xvid_global(XVID_GBL_SRAM) failed\n", stderr);
+        return false;
+    }
+
+    unsigned long long total = 0;
+    for (int i = 0; i < sram.num_objects; ++i) {
+        total += sram.objects[i].accesses;
+    }
+    if (total == 0) {
+        fputs("decbench: no SRAM accesses counted, rebuild with -DSRAM_PROFILING\n", stderr);
+        return false;
+    }
+
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "decbench: cannot write %s\n", path.c_str());
+        return false;
+    }
+    fprintf(f, "# SRAM profile of %s\n", clip.c_str());
+    fprintf(f, "frames %zu\n", frames);
+    for (int i = 0; i < sram.num_objects; ++i) {
+        fprintf(f, "%s %u %llu\n", sram.objects[i].name, sram.objects[i].bytes, sram.objects[i].accesses);
+    }
+    return fclose(f) == 0;
+}
+
+const char* usage =
+    "Usage: decbench <file.m4v> [options...]\n"
+    "Options:\n"
+    "  -loops N\tDecode the file N times | Default: 1\n"
+    "  -frames N\tStop after N output frames per loop | Default: whole file\n"
+    "  -rgb\tConvert output to RGB565 like the player | Default: off (XVID_CSP_INTERNAL)\n"
+    "  -fd\tFast decoding | Default: on\n"
+    "  -ld\tLow-delay mode | Default: off\n"
+    "  -dbl\tEnable luma deblocking filter | Default: off\n"
+    "  -dbc\tEnable chroma deblocking filter | Default: off\n"
+    "  -drl\tEnable luma deringing filter | Default: off\n"
+    "  -drc\tEnable chroma deringing filter | Default: off\n"
+    "  -sramprofile FILE\tWrite the SRAM access profile (SRAM_PROFILING builds)\n"
+    "\n"
+    "  Flags that are on by default can be turned off with -N (e.g. -Nfd).\n";
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fputs(usage, stderr);
+        return 2;
+    }
+
+    BenchOptions options;
+    options.filename = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-loops" && i + 1 < argc) {
+            options.loops = std::max(1, atoi(argv[++i]));
+        } else if (arg == "-frames" && i + 1 < argc) {
+            options.maxFrames = std::max(0, atoi(argv[++i]));
+        } else if (arg == "-sramprofile" && i + 1 < argc) {
+            options.sramProfile = argv[++i];
+        } else if (arg == "-rgb") {
+            options.convertRGB565 = true;
+        } else if (arg == "-fd") {
+            options.fastDecoding = true;
+        } else if (arg == "-ld") {
+            options.lowDelayMode = true;
+        } else if (arg == "-dbl") {
+            options.deblockLuma = true;
+        } else if (arg == "-dbc") {
+            options.deblockChroma = true;
+        } else if (arg == "-drl") {
+            options.deringLuma = true;
+        } else if (arg == "-drc") {
+            options.deringChroma = true;
+        } else if (arg == "-Nrgb") {
+            options.convertRGB565 = false;
+        } else if (arg == "-Nfd") {
+            options.fastDecoding = false;
+        } else if (arg == "-Nld") {
+            options.lowDelayMode = false;
+        } else if (arg == "-Ndbl") {
+            options.deblockLuma = false;
+        } else if (arg == "-Ndbc") {
+            options.deblockChroma = false;
+        } else if (arg == "-Ndrl") {
+            options.deringLuma = false;
+        } else if (arg == "-Ndrc") {
+            options.deringChroma = false;
+        } else {
+            fprintf(stderr, "decbench: Unknown option: %s\n%s", arg.c_str(), usage);
+            return 2;
+        }
+    }
+
+    std::vector<uint8_t> fileData;
+    if (!ReadWholeFile(options.filename, fileData)) {
+        fprintf(stderr, "decbench: Failed to open video file: %s\n", options.filename.c_str());
+        return 1;
+    }
+    const size_t fileSize = fileData.size();
+    fileData.resize(fileSize + FILE_READ_BUFFER_PADDING, 0);
+
+    // no SRAM on the host, xvid_malloc_sram() falls back to the heap
+    xvid_gbl_init_t xvid_gbl_init{};
+    xvid_gbl_init.version = XVID_VERSION;
+    if (xvid_global(NULL, XVID_GBL_INIT, &xvid_gbl_init, NULL) < 0) {
+        fputs("decbench: xvid_global(XVID_GBL_INIT) failed\n", stderr);
+        return 1;
+    }
+
+    BenchTimes times;
+    int width = 0, height = 0;
+    for (int loop = 0; loop < options.loops; ++loop) {
+        const std::string error = DecodeOnce(options, fileData.data(), fileSize, times, width, height);
+        if (!error.empty()) {
+            fprintf(stderr, "decbench: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    const size_t framesDecoded =
+        times.IFrame_DecodeTimes.size() + times.PFrame_DecodeTimes.size() +
+        times.BFrame_DecodeTimes.size() + times.SFrame_DecodeTimes.size();
+    const double seconds = (double)times.totalNanoseconds / 1e9;
+
+    printf("File: %s (%zu bytes, %dx%d, %d loop%s, %s)\n",
+        options.filename.c_str(), fileSize, width, height,
+        options.loops, options.loops == 1 ? "" : "s",
+        options.convertRGB565 ? "RGB565" : "XVID_CSP_INTERNAL");
+    printf("Profiling Info Summary (ns):\n");
+    printf("I dec: %s\n", stats::short_stats(times.IFrame_DecodeTimes).c_str());
+    printf("P dec: %s\n", stats::short_stats(times.PFrame_DecodeTimes).c_str());
+    printf("B dec: %s\n", stats::short_stats(times.BFrame_DecodeTimes).c_str());
+    printf("S dec: %s\n", stats::short_stats(times.SFrame_DecodeTimes).c_str());
+    printf("N dec: %s\n", stats::short_stats(times.NFrame_DecodeTimes).c_str());
+    printf("Wasted dec: %s\n", stats::short_stats(times.WastedFrame_DecodeTimes).c_str());
+    printf("Frames: %zu in %.3f s, %.1f fps\n",
+        framesDecoded, seconds, seconds > 0 ? (double)framesDecoded / seconds : 0.0);
+
+    if (!options.sramProfile.empty() && !WriteSramProfile(options.sramProfile, options.filename, framesDecoded)) {
+        return 1;
+    }
+
+    return 0;
+}
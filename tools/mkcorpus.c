@@ -0,0 +1,398 @@
+/*
+ * Generates the decoder conformance clips in tests/conformance/ with the
+ * in-tree xvid encoder.
+ *
+ * The clips are committed, this tool only exists so the corpus can be
+ * reproduced or extended. Every clip is 176x144 and a couple dozen frames so
+ * `make check` stays fast, while each one forces a specific decoder path:
+ * VOP types, quarterpel, interlacing, MPEG quantisation with custom matrices
+ * and resync markers.
+ *
+ * The stuffing clips are one encoded I-VOP followed by a hand written VOP
+ * header and macroblock stuffing up to the end of the file, much more than
+ * XVID_BS_BOUNCE_MARGIN. Decoding them must not read past the input buffer.
+ *
+ * Usage: mkcorpus <output dir>
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xvid.h>
+
+#define CLIP_WIDTH  176
+#define CLIP_HEIGHT 144
+
+#define BITSTREAM_SIZE (1 << 20)
+
+typedef enum {
+	MOTION_PAN,        /* integer + fractional pan, exercises half/quarterpel MC */
+	MOTION_ZOOM,       /* slow zoom + rotation, only GMC predicts this cheaply */
+	MOTION_STILL,      /* runs of identical frames, produces not coded VOPs */
+	MOTION_FIELDS,     /* top and bottom field move in opposite directions */
+	MOTION_SLIDES      /* static picture with a small moving box, one slide change,
+	                      most macroblocks are not coded */
+} motion_t;
+
+typedef struct {
+	const char *name;
+	int frames;
+	int max_bframes;
+	int max_key_interval;
+	int quant;
+	int vol_flags;
+	int vop_flags;
+	int frame_drop_ratio;
+	int num_slices;
+	int custom_matrices;
+	motion_t motion;
+} clip_t;
+
+#define VOP_DEFAULT (XVID_VOP_HALFPEL | XVID_VOP_INTER4V)
+
+static const clip_t clips[] = {
+	/* name           frames bf key  q  vol flags                                  vop flags                               drop slices mtx motion */
+	{ "ip_h263",         24, 0,  10, 4, 0,                                         VOP_DEFAULT,                               0, 1, 0, MOTION_PAN },
+	{ "ipb_h263",        24, 2,  12, 5, 0,                                         VOP_DEFAULT,                               0, 1, 0, MOTION_PAN },
+	{ "svop_gmc",        20, 0, 100, 4, XVID_VOL_GMC,                              VOP_DEFAULT,                               0, 1, 0, MOTION_ZOOM },
+	{ "nvop_still",      24, 0, 100, 4, 0,                                         VOP_DEFAULT,                              60, 1, 0, MOTION_STILL },
+	{ "qpel",            24, 1,  12, 4, XVID_VOL_QUARTERPEL,                       VOP_DEFAULT,                               0, 1, 0, MOTION_PAN },
+	{ "interlaced",      12, 1,   6, 4, XVID_VOL_INTERLACING,                      VOP_DEFAULT | XVID_VOP_TOPFIELDFIRST,      0, 1, 0, MOTION_FIELDS },
+	{ "mpeg_quant",      20, 1,  10, 6, XVID_VOL_MPEGQUANT,                        VOP_DEFAULT,                               0, 1, 0, MOTION_PAN },
+	{ "mpeg_matrices",   20, 0,  10, 6, XVID_VOL_MPEGQUANT,                        VOP_DEFAULT,                               0, 1, 1, MOTION_PAN },
+	{ "resync_slices",   20, 1,  10, 4, 0,                                         VOP_DEFAULT,                               0, 4, 0, MOTION_PAN },
+	{ "qpel_gmc_mpeg",   20, 1, 100, 5, XVID_VOL_QUARTERPEL | XVID_VOL_GMC | XVID_VOL_MPEGQUANT, VOP_DEFAULT,                0, 1, 0, MOTION_ZOOM },
+	{ "slides",          24, 0, 100, 4, 0,                                         VOP_DEFAULT,                               0, 1, 0, MOTION_SLIDES },
+	{ "slides_b",        24, 2, 100, 4, 0,                                         VOP_DEFAULT,                               0, 1, 0, MOTION_SLIDES },
+	{ "still_p",         12, 0, 100, 4, 0,                                         VOP_DEFAULT,                               0, 1, 0, MOTION_STILL },
+};
+
+typedef struct {
+	const char *name;
+	int coding_type;   /* of the stuffed VOP, 0 = I, 1 = P */
+} stuffing_clip_t;
+
+static const stuffing_clip_t stuffing_clips[] = {
+	{ "stuffing_i", 0 },
+	{ "stuffing_p", 1 },
+};
+
+#define STUFFING_BYTES 8192
+
+/* Deliberately far from flat so most blocks carry several AC coefficients. */
+static double texture(double x, double y)
+{
+	return 128.0
+		+ 60.0 * sin(x * 0.21 + sin(y * 0.05) * 2.0)
+		+ 35.0 * cos(y * 0.17 - x * 0.03)
+		+ 20.0 * sin((x + y) * 0.61);
+}
+
+static unsigned char clamp255(double v)
+{
+	if (v < 0.0) return 0;
+	if (v > 255.0) return 255;
+	return (unsigned char)(v + 0.5);
+}
+
+static void source_position(const clip_t *clip, int n, int x, int y, double *sx, double *sy)
+{
+	switch (clip->motion) {
+	case MOTION_PAN:
+		*sx = x + n * 1.75;
+		*sy = y + n * 0.75;
+		break;
+	case MOTION_ZOOM: {
+		const double cx = CLIP_WIDTH / 2.0, cy = CLIP_HEIGHT / 2.0;
+		const double s = 1.0 + n * 0.012;
+		const double a = n * 0.004;
+		*sx = cx + ((x - cx) * cos(a) - (y - cy) * sin(a)) / s + n * 0.5;
+		*sy = cy + ((x - cx) * sin(a) + (y - cy) * cos(a)) / s;
+		break;
+	}
+	case MOTION_STILL:
+		/* move every fourth frame, repeat the picture otherwise */
+		*sx = x + (n / 4) * 3.0;
+		*sy = y;
+		break;
+	case MOTION_FIELDS:
+		*sx = x + ((y & 1) ? -n * 1.5 : n * 2.0);
+		*sy = y + n * 0.5;
+		break;
+	case MOTION_SLIDES: {
+		const int bx = 20 + n * 4, by = 40;
+		*sx = x + (n >= 14 ? 40.0 : 0.0);
+		*sy = y;
+		if (x >= bx && x < bx + 24 && y >= by && y < by + 24) {
+			*sx += 300.0;
+			*sy += n * 1.5;
+		}
+		break;
+	}
+	}
+}
+
+static void render_frame(const clip_t *clip, int n, unsigned char *img)
+{
+	unsigned char *py = img;
+	unsigned char *pu = img + CLIP_WIDTH * CLIP_HEIGHT;
+	unsigned char *pv = pu + (CLIP_WIDTH / 2) * (CLIP_HEIGHT / 2);
+	int x, y;
+
+	for (y = 0; y < CLIP_HEIGHT; y++) {
+		for (x = 0; x < CLIP_WIDTH; x++) {
+			double sx, sy;
+			source_position(clip, n, x, y, &sx, &sy);
+			py[y * CLIP_WIDTH + x] = clamp255(texture(sx, sy));
+		}
+	}
+	for (y = 0; y < CLIP_HEIGHT / 2; y++) {
+		for (x = 0; x < CLIP_WIDTH / 2; x++) {
+			double sx, sy;
+			source_position(clip, n, 2 * x, 2 * y, &sx, &sy);
+			pu[y * (CLIP_WIDTH / 2) + x] = clamp255(128.0 + 40.0 * sin(sx * 0.09) * cos(sy * 0.07));
+			pv[y * (CLIP_WIDTH / 2) + x] = clamp255(128.0 + 40.0 * cos(sx * 0.05 + sy * 0.11));
+		}
+	}
+}
+
+static int encode_clip(const clip_t *clip, const char *dir)
+{
+	static unsigned char intra_matrix[64], inter_matrix[64];
+	xvid_enc_create_t create;
+	unsigned char *img, *bitstream;
+	char path[1024];
+	char types[256];
+	int n, ntypes = 0, i;
+	FILE *f;
+
+	memset(&create, 0, sizeof(create));
+	create.version = XVID_VERSION;
+	create.width = CLIP_WIDTH;
+	create.height = CLIP_HEIGHT;
+	create.fincr = 1;
+	create.fbase = 24;
+	create.max_key_interval = clip->max_key_interval;
+	create.max_bframes = clip->max_bframes;
+	create.bquant_ratio = 150;
+	create.bquant_offset = 100;
+	create.frame_drop_ratio = clip->frame_drop_ratio;
+	create.num_slices = clip->num_slices;
+	create.num_threads = 1;
+
+	if (xvid_encore(NULL, XVID_ENC_CREATE, &create, NULL) < 0) {
+		fprintf(stderr, "mkcorpus: %s: encoder create failed\n", clip->name);
+		return -1;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s.m4v", dir, clip->name);
+	f = fopen(path, "wb");
+	img = malloc(CLIP_WIDTH * CLIP_HEIGHT * 3 / 2);
+	bitstream = malloc(BITSTREAM_SIZE);
+	if (!f || !img || !bitstream) {
+		fprintf(stderr, "mkcorpus: %s: cannot open output\n", path);
+		return -1;
+	}
+
+	/* steep, asymmetric matrices so a mixed up intra/inter table is visible */
+	for (i = 0; i < 64; i++) {
+		intra_matrix[i] = (unsigned char)(8 + (i % 8) * 3 + (i / 8) * 2);
+		inter_matrix[i] = (unsigned char)(16 + (i % 8) + (i / 8) * 4);
+	}
+
+	/* trailing calls with no input flush the queued B-frames */
+	for (n = 0; n < clip->frames + clip->max_bframes + 1; n++) {
+		xvid_enc_frame_t frame;
+		xvid_enc_stats_t stats;
+		int len;
+
+		memset(&frame, 0, sizeof(frame));
+		frame.version = XVID_VERSION;
+		frame.vol_flags = clip->vol_flags;
+		frame.vop_flags = clip->vop_flags;
+		frame.motion = XVID_ME_HALFPELREFINE16 | XVID_ME_HALFPELREFINE8 | XVID_ME_EXTSEARCH16;
+		if (clip->vol_flags & XVID_VOL_QUARTERPEL)
+			frame.motion |= XVID_ME_QUARTERPELREFINE16 | XVID_ME_QUARTERPELREFINE8;
+		if (clip->vol_flags & XVID_VOL_GMC)
+			frame.motion |= XVID_ME_GME_REFINE;
+		if (clip->custom_matrices) {
+			frame.quant_intra_matrix = intra_matrix;
+			frame.quant_inter_matrix = inter_matrix;
+		}
+		frame.type = XVID_TYPE_AUTO;
+		frame.quant = clip->quant;
+		frame.bitstream = bitstream;
+		frame.length = BITSTREAM_SIZE;
+
+		if (n < clip->frames) {
+			render_frame(clip, n, img);
+			frame.input.csp = XVID_CSP_I420;
+			frame.input.plane[0] = img;
+			frame.input.stride[0] = CLIP_WIDTH;
+		} else {
+			frame.input.csp = XVID_CSP_NULL;
+		}
+
+		memset(&stats, 0, sizeof(stats));
+		stats.version = XVID_VERSION;
+
+		len = xvid_encore(create.handle, XVID_ENC_ENCODE, &frame, &stats);
+		if (len < 0)
+			break;
+		if (len > 0) {
+			fwrite(bitstream, 1, len, f);
+			if (ntypes < (int)sizeof(types) - 1)
+				types[ntypes++] = " IPBSN"[stats.type > 0 && stats.type <= 4 ? stats.type : (len < 16 ? 5 : 0)];
+		}
+	}
+	types[ntypes] = '\0';
+
+	xvid_encore(create.handle, XVID_ENC_DESTROY, NULL, NULL);
+	fclose(f);
+	free(img);
+	free(bitstream);
+
+	printf("%-16s %s\n", clip->name, types);
+	return 0;
+}
+
+typedef struct {
+	unsigned char *buf;
+	size_t bits;
+} bit_writer_t;
+
+static void put_bits(bit_writer_t *bw, unsigned int value, int n)
+{
+	while (n-- > 0) {
+		if ((value >> n) & 1)
+			bw->buf[bw->bits / 8] |= 0x80 >> (bw->bits % 8);
+		bw->bits++;
+	}
+}
+
+static int write_stuffing_clip(const stuffing_clip_t *clip, const char *dir)
+{
+	const clip_t *source = clips;
+	xvid_enc_create_t create;
+	xvid_enc_frame_t frame;
+	unsigned char *img, *bitstream;
+	bit_writer_t bw;
+	char path[1024];
+	int len, i, stuffing_bits;
+	FILE *f;
+
+	/* the first frame of still_p, the clips share its VOL */
+	while (strcmp(source->name, "still_p") != 0)
+		source++;
+
+	memset(&create, 0, sizeof(create));
+	create.version = XVID_VERSION;
+	create.width = CLIP_WIDTH;
+	create.height = CLIP_HEIGHT;
+	create.fincr = 1;
+	create.fbase = 24;
+	create.max_key_interval = source->max_key_interval;
+	create.num_threads = 1;
+
+	if (xvid_encore(NULL, XVID_ENC_CREATE, &create, NULL) < 0) {
+		fprintf(stderr, "mkcorpus: %s: encoder create failed\n", clip->name);
+		return -1;
+	}
+
+	img = malloc(CLIP_WIDTH * CLIP_HEIGHT * 3 / 2);
+	bitstream = calloc(1, BITSTREAM_SIZE);
+	if (!img || !bitstream) {
+		fprintf(stderr, "mkcorpus: %s: out of memory\n", clip->name);
+		return -1;
+	}
+
+	memset(&frame, 0, sizeof(frame));
+	frame.version = XVID_VERSION;
+	frame.vop_flags = source->vop_flags;
+	frame.type = XVID_TYPE_IVOP;
+	frame.quant = source->quant;
+	frame.bitstream = bitstream;
+	frame.length = BITSTREAM_SIZE;
+	render_frame(source, 0, img);
+	frame.input.csp = XVID_CSP_I420;
+	frame.input.plane[0] = img;
+	frame.input.stride[0] = CLIP_WIDTH;
+
+	len = xvid_encore(create.handle, XVID_ENC_ENCODE, &frame, NULL);
+	xvid_encore(create.handle, XVID_ENC_DESTROY, NULL, NULL);
+	if (len <= 0) {
+		fprintf(stderr, "mkcorpus: %s: encoding the I-VOP failed\n", clip->name);
+		return -1;
+	}
+
+	/* the next VOP, as the VOL above has it: 24 ticks per second (5 bit
+	 * time increments), rectangular, no complexity estimation, progressive */
+	bw.buf = bitstream + len;
+	bw.bits = 0;
+	put_bits(&bw, 0x000001b6, 32);  /* vop_start_code */
+	put_bits(&bw, clip->coding_type, 2);
+	put_bits(&bw, 0, 1);            /* modulo_time_base */
+	put_bits(&bw, 1, 1);            /* marker */
+	put_bits(&bw, 1, 5);            /* vop_time_increment */
+	put_bits(&bw, 1, 1);            /* marker */
+	put_bits(&bw, 1, 1);            /* vop_coded */
+	if (clip->coding_type == 1)
+		put_bits(&bw, 0, 1);        /* vop_rounding_type */
+	put_bits(&bw, 0, 3);            /* intra_dc_vlc_thr */
+	put_bits(&bw, source->quant, 5);
+	if (clip->coding_type == 1)
+		put_bits(&bw, 1, 3);        /* vop_fcode_forward */
+
+	/* the P-VOP's first macroblock is not coded, which byte aligns the
+	 * 55 bit header for the 10 bit stuffing codes */
+	if (clip->coding_type == 1)
+		put_bits(&bw, 1, 1);        /* not_coded */
+
+	/* the next macroblock never comes. The file ends on a byte and a code
+	 * boundary, so repeating its last 45 bytes continues the stuffing */
+	stuffing_bits = clip->coding_type == 0 ? 9 : 10;
+	for (i = 0; bw.bits < 8 * STUFFING_BYTES || bw.bits % 8 != 0; i++)
+		put_bits(&bw, 0x001, stuffing_bits);
+	len += (int)(bw.bits / 8);
+
+	snprintf(path, sizeof(path), "%s/%s.m4v", dir, clip->name);
+	f = fopen(path, "wb");
+	if (!f) {
+		fprintf(stderr, "mkcorpus: %s: cannot open output\n", path);
+		return -1;
+	}
+	fwrite(bitstream, 1, len, f);
+	fclose(f);
+	free(img);
+	free(bitstream);
+
+	printf("%-16s I%c + %d bytes of stuffing\n", clip->name, " IP"[clip->coding_type + 1], STUFFING_BYTES);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	xvid_gbl_init_t init;
+	size_t i;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: mkcorpus <output dir>\n");
+		return 2;
+	}
+
+	memset(&init, 0, sizeof(init));
+	init.version = XVID_VERSION;
+	xvid_global(NULL, XVID_GBL_INIT, &init, NULL);
+
+	for (i = 0; i < sizeof(clips) / sizeof(clips[0]); i++) {
+		if (encode_clip(&clips[i], argv[1]) < 0)
+			return 1;
+	}
+	for (i = 0; i < sizeof(stuffing_clips) / sizeof(stuffing_clips[0]); i++) {
+		if (write_stuffing_clip(&stuffing_clips[i], argv[1]) < 0)
+			return 1;
+	}
+	return 0;
+}
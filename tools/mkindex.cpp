@@ -0,0 +1,128 @@
+// Builds the seek index sidecar the player uses for arrow key seeking.
+//
+// Scans a raw .m4v elementary stream (the same files the player takes) for
+// VOP start codes and records the byte offset and time stamp of every I-VOP,
+// see src/videoplayer/StreamIndex.hpp for the format. Only the VOL and the
+// start of each VOP header are parsed, nothing is decoded.
+//
+// Usage: mkindex <video.tns> [<index file>]
+//   the index file defaults to video.idx.tns, copy it next to the video
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../src/videoplayer/StreamIndex.hpp"
+
+namespace {
+
+bool ReadWholeFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Returns an empty string on success, an error message otherwise.
+std::string BuildIndex(const std::vector<uint8_t>& data, SeekIndexHeader& header, std::vector<SeekIndexEntry>& entries) {
+    const size_t volPosition = findVOLStartCode(data.data(), data.size());
+    if (volPosition == (size_t)-1) {
+        return "no VOL header";
+    }
+    const vol_timing_t vol = parse_vol_timing(data.data() + volPosition + 4, data.size() - volPosition - 4, 0);
+    if (!vol.ok) {
+        return "cannot parse the VOL timing information";
+    }
+
+    header = SeekIndexHeader{SEEK_INDEX_MAGIC, SEEK_INDEX_VERSION, vol.R, 0};
+
+    // time_base only advances on I/P/S-VOPs, B-VOP modulo_time_base is relative to the last of those
+    uint64_t timeBase = 0;
+    uint64_t firstTime = 0;
+    bool seenVOP = false;
+    for (size_t i = volPosition + 4; i + 4 < data.size(); i++) {
+        if (data[i] != 0x00 || data[i + 1] != 0x00 || data[i + 2] != 0x01) {
+            continue;
+        }
+        const uint8_t code = data[i + 3];
+        if (code >= VOL_START_CODE_MIN && code <= VOL_START_CODE_MAX) {
+            const vol_timing_t repeated = parse_vol_timing(data.data() + i + 4, data.size() - i - 4, 0);
+            if (repeated.ok && repeated.R != vol.R) {
+                return "vop_time_increment_resolution changes at offset " + std::to_string(i) + ", not supported";
+            }
+            continue;
+        }
+        if (code != VOP_START_CODE_BYTE) {
+            continue;
+        }
+
+        const vop_timing_t vop = parse_vop_timing(data.data() + i + 4, data.size() - i - 4, vol.inc_bits);
+        if (!vop.ok) {
+            return "truncated VOP header at offset " + std::to_string(i);
+        }
+        if (vop.coding_type == VOP_CODING_B) {
+            continue;
+        }
+        timeBase += vop.modulo_time;
+        const uint64_t time = timeBase * vol.R + vop.increment;
+        if (!seenVOP) {
+            firstTime = time;
+            seenVOP = true;
+        }
+
+        if (vop.coding_type == VOP_CODING_I) {
+            if (i > UINT32_MAX || time - firstTime > UINT32_MAX) {
+                return "video too long for the index format";
+            }
+            entries.push_back(SeekIndexEntry{(uint32_t)i, (uint32_t)(time - firstTime)});
+        }
+    }
+    header.entryCount = (uint32_t)entries.size();
+    return "";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fputs("Usage: mkindex <video.tns> [<index file>]\n", stderr);
+        return 2;
+    }
+    const std::string videoPath = argv[1];
+    const std::string indexPath = argc > 2 ? argv[2] : SeekIndexPathFor(videoPath);
+
+    std::vector<uint8_t> data;
+    if (!ReadWholeFile(videoPath, data)) {
+        fprintf(stderr, "mkindex: cannot read %s\n", videoPath.c_str());
+        return 1;
+    }
+
+    SeekIndexHeader header{};
+    std::vector<SeekIndexEntry> entries;
+    const std::string error = BuildIndex(data, header, entries);
+    if (!error.empty()) {
+        fprintf(stderr, "mkindex: %s: %s\n", videoPath.c_str(), error.c_str());
+        return 1;
+    }
+
+    FILE* out = fopen(indexPath.c_str(), "wb");
+    if (!out ||
+        fwrite(&header, sizeof(header), 1, out) != 1 ||
+        (!entries.empty() && fwrite(entries.data(), sizeof(SeekIndexEntry), entries.size(), out) != entries.size())) {
+        fprintf(stderr, "mkindex: cannot write %s\n", indexPath.c_str());
+        if (out) {
+            fclose(out);
+        }
+        return 1;
+    }
+    fclose(out);
+
+    const double seconds = entries.empty() ? 0.0 : (double)entries.back().timingTicks / header.timeIncrementResolution;
+    printf("%s: %zu I-VOPs, last at %.1f s\n", indexPath.c_str(), entries.size(), seconds);
+    return 0;
+}
@@ -0,0 +1,149 @@
+// SRAM placement planner.
+//
+// Reads SRAM access profiles written by `decbench -sramprofile` (a build with
+// -DSRAM_PROFILING) and prints src/xvid/utils/sram_placement.h: every object
+// that was accessed, ordered by accesses per byte and frame. At XVID_GBL_INIT
+// the decoder walks that list and puts each object into the SRAM pool that
+// still fits, the rest is allocated from the heap. Objects that were never
+// accessed are left out of the list and so never take up SRAM.
+//
+// The profiles' accesses are summed and divided by their summed frames, the
+// bytes of an object are the largest any profile saw. A summary with the
+// running total of the placed bytes goes to stderr.
+//
+// Usage: sramplan <profile>... > src/xvid/utils/sram_placement.h
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct SramObject {
+    std::string name;
+    unsigned int bytes = 0;
+    unsigned long long accesses = 0;
+
+    double AccessesPerFrame(unsigned long long frames) const {
+        return frames ? (double)accesses / (double)frames : 0.0;
+    }
+};
+
+bool ReadProfile(const std::string& path, std::map<std::string, SramObject>& objects,
+                 unsigned long long& frames) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    bool sawFrames = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        fields >> name;
+        if (name == "frames") {
+            unsigned long long n = 0;
+            if (!(fields >> n)) {
+                return false;
+            }
+            frames += n;
+            sawFrames = true;
+            continue;
+        }
+
+        unsigned int bytes = 0;
+        unsigned long long accesses = 0;
+        if (!(fields >> bytes >> accesses)) {
+            return false;
+        }
+        SramObject& object = objects[name];
+        object.name = name;
+        object.bytes = std::max(object.bytes, bytes);
+        object.accesses += accesses;
+    }
+    return sawFrames;
+}
+
+std::string EnumName(const std::string& name) {
+    std::string e = "SRAM_";
+    for (char c : name) {
+        e += (char)toupper((unsigned char)c);
+    }
+    return e;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fputs("Usage: sramplan <profile>... > sram_placement.h\n", stderr);
+        return 2;
+    }
+
+    std::map<std::string, SramObject> byName;
+    unsigned long long frames = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!ReadProfile(argv[i], byName, frames)) {
+            fprintf(stderr, "sramplan: missing or malformed profile %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (frames == 0) {
+        fputs("sramplan: the profiles hold no frames\n", stderr);
+        return 1;
+    }
+
+    std::vector<SramObject> placed, unused;
+    for (const auto& entry : byName) {
+        const SramObject& object = entry.second;
+        (object.accesses && object.bytes ? placed : unused).push_back(object);
+    }
+    std::sort(placed.begin(), placed.end(), [frames](const SramObject& a, const SramObject& b) {
+        return a.AccessesPerFrame(frames) * b.bytes > b.AccessesPerFrame(frames) * a.bytes;
+    });
+
+    printf("/* Generated by tools/sramplan from %d profile%s (%llu frames), do not edit.\n",
+           argc - 1, argc == 2 ? "" : "s", frames);
+    printf(" * Regenerate with `make sram-plan`.\n");
+    printf(" *\n");
+    printf(" * Ordered by accesses per byte and frame, sram_plan_init() places them\n");
+    printf(" * in this order as long as they fit. Never accessed, so never placed:\n");
+    std::string line = " *";
+    for (const SramObject& object : unused) {
+        if (line.size() + object.name.size() + 1 > 78) {
+            printf("%s\n", line.c_str());
+            line = " *";
+        }
+        line += " " + object.name;
+    }
+    printf("%s%s\n */\n\n", line.c_str(), unused.empty() ? " (none)" : "");
+    printf("static const SRAM_PLACEMENT sram_placement[] = {\n");
+    for (const SramObject& object : placed) {
+        const double perFrame = object.AccessesPerFrame(frames);
+        printf("\t{%s, %u, %.0f}, /* %.2f per byte */\n",
+               EnumName(object.name).c_str(), object.bytes, perFrame, perFrame / object.bytes);
+    }
+    printf("};\n");
+
+    fprintf(stderr, "%-16s %8s %14s %10s %10s\n", "object", "bytes", "accesses/frame", "per byte", "total");
+    unsigned long long total = 0;
+    for (const SramObject& object : placed) {
+        const double perFrame = object.AccessesPerFrame(frames);
+        total += object.bytes;
+        fprintf(stderr, "%-16s %8u %14.0f %10.2f %10llu\n",
+                object.name.c_str(), object.bytes, perFrame, perFrame / object.bytes, total);
+    }
+    for (const SramObject& object : unused) {
+        fprintf(stderr, "%-16s %8u %14s\n", object.name.c_str(), object.bytes, "never");
+    }
+    return 0;
+}
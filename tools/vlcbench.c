@@ -0,0 +1,367 @@
+/*
+ * Host-side benchmark for the DCT coefficient VLC decoder.
+ *
+ * Writes random coefficient-heavy intra and inter blocks (regular codes and
+ * all three escape modes) with the bitstream writer, then decodes them with
+ * the decoder's get_intra_block / get_inter_block_h263 and with a copy of the
+ * original 4096 entry REVERSE_EVENT table decoder kept here as reference.
+ * Both have to produce identical blocks, the time per block is reported for
+ * each.
+ *
+ * Usage: vlcbench [blocks] [loops]
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xvid.h>
+
+#include "portab.h"
+#include "global.h"
+#include "bitstream/bitstream.h"
+#include "bitstream/mbcoding.h"
+#include "bitstream/vlc_codes.h"
+#include "bitstream/zigzag.h"
+
+#define DEFAULT_BLOCKS 20000
+#define DEFAULT_LOOPS  20
+
+/* read at run time so the reference decoder, which is compiled into this
+ * file, can't constant fold the dequantisation */
+static volatile int inter_quant = 4;
+
+/*****************************************************************************
+ * reference decoder, the 12 bit direct lookup the packed tables replaced
+ ****************************************************************************/
+
+static REVERSE_EVENT reference_DCT3D[2][4096];
+
+static void
+init_reference_tables(void)
+{
+	int intra, i, j;
+
+	memset(reference_DCT3D, 0, sizeof(reference_DCT3D));
+	for (intra = 0; intra < 2; intra++) {
+		for (i = 0; i < 102; i++) {
+			const VLC_TABLE *t = &coeff_tab[intra][i];
+			for (j = 0; j < (1 << (12 - t->vlc.len)); j++) {
+				reference_DCT3D[intra][(t->vlc.code << (12 - t->vlc.len)) | j].len = t->vlc.len;
+				reference_DCT3D[intra][(t->vlc.code << (12 - t->vlc.len)) | j].event = t->event;
+			}
+		}
+	}
+}
+
+#define GET_BITS(cache, n) ((cache)>>(32-(n)))
+
+static __inline int
+reference_get_coeff(Bitstream * bs, int *run, int *last, int intra)
+{
+	uint32_t mode;
+	int32_t level;
+	REVERSE_EVENT *reverse_event;
+
+	uint32_t cache = BitstreamShowBits(bs, 32);
+
+	if (GET_BITS(cache, 7) != ESCAPE) {
+		reverse_event = &reference_DCT3D[intra][GET_BITS(cache, 12)];
+
+		if ((level = reverse_event->event.level) == 0)
+			goto error;
+
+		*last = reverse_event->event.last;
+		*run  = reverse_event->event.run;
+
+		BitstreamSkip(bs, reverse_event->len+1);
+
+		return (GET_BITS(cache, reverse_event->len+1)&0x01) ? -level : level;
+	}
+
+	cache <<= 7;
+
+	if ((mode = GET_BITS(cache, 2)) < 3) {
+		const int skip[3] = {1, 1, 2};
+		cache <<= skip[mode];
+
+		reverse_event = &reference_DCT3D[intra][GET_BITS(cache, 12)];
+
+		if ((level = reverse_event->event.level) == 0)
+			goto error;
+
+		*last = reverse_event->event.last;
+		*run  = reverse_event->event.run;
+
+		if (mode < 2) {
+			level += max_level[intra][*last][*run];
+		} else {
+			*run += max_run[intra][*last][level] + 1;
+		}
+
+		BitstreamSkip(bs, 7 + skip[mode] + reverse_event->len + 1);
+
+		return (GET_BITS(cache, reverse_event->len+1)&0x01) ? -level : level;
+	}
+
+	cache <<= 2;
+	*last =  GET_BITS(cache, 1);
+	*run  = (GET_BITS(cache, 7)&0x3f);
+	level = (GET_BITS(cache, 20)&0xfff);
+
+	BitstreamSkip(bs, 30);
+
+	return (level << 20) >> 20;
+
+  error:
+	*run = 64;
+	return 0;
+}
+
+/* not inlined into the benchmark loop, like the decoder's functions */
+static int __attribute__((noinline))
+reference_intra_block(Bitstream * bs, int16_t * block)
+{
+	const uint16_t *scan = scan_tables[0];
+	int level, run, last = 0;
+	int coeff = 0, last_pos = 0;
+
+	do {
+		level = reference_get_coeff(bs, &run, &last, 1);
+		coeff += run;
+		if (coeff & ~63)
+			break;
+		block[scan[coeff]] = level;
+		last_pos = coeff;
+		coeff++;
+	} while (!last);
+
+	return last_pos;
+}
+
+static int __attribute__((noinline))
+reference_inter_block_h263(Bitstream * bs, int16_t * block, const int quant)
+{
+	const uint16_t *scan = scan_tables[0];
+	const uint16_t quant_m_2 = quant << 1;
+	const uint16_t quant_add = (quant & 1 ? quant : quant - 1);
+	int level, run, last = 0;
+	int p = 0, last_pos = 0;
+
+	do {
+		level = reference_get_coeff(bs, &run, &last, 0);
+		p += run;
+		if (p & ~63)
+			break;
+		if (level < 0) {
+			level = level*quant_m_2 - quant_add;
+			block[scan[p]] = (level >= -2048 ? level : -2048);
+		} else {
+			level = level * quant_m_2 + quant_add;
+			block[scan[p]] = (level <= 2047 ? level : 2047);
+		}
+		last_pos = p;
+		p++;
+	} while (!last);
+
+	return last_pos;
+}
+
+/*****************************************************************************
+ * test stream
+ ****************************************************************************/
+
+/* picks a table entry with the given last flag whose run still fits, codes
+ * of length n are drawn with probability 2^-n like in a real stream */
+static const VLC_TABLE *
+random_entry(int intra, int last, int max_run_left)
+{
+	for (;;) {
+		const REVERSE_EVENT *e = &reference_DCT3D[intra][rand() & 4095];
+		int i;
+
+		if (e->event.level == 0 || e->event.last != last || e->event.run > max_run_left)
+			continue;
+		for (i = 0; i < 102; i++) {
+			const VLC_TABLE *t = &coeff_tab[intra][i];
+			if (t->event.last == e->event.last && t->event.run == e->event.run &&
+				t->event.level == e->event.level)
+				return t;
+		}
+	}
+}
+
+/* writes one block of coefficients, intra blocks are dense (I-frames at a
+ * low quantiser), inter blocks a bit sparser */
+static void
+write_block(Bitstream * bs, int intra)
+{
+	const int coeffs = intra ? 24 + rand() % 32 : 6 + rand() % 24;
+	int pos = 0, n;
+
+	for (n = 0; ; n++) {
+		const int last = (n + 1 >= coeffs) || pos >= 60;
+		const int kind = rand() % 16;
+		/* positions left for this run, keeping one for the last coefficient */
+		const int room = 63 - pos - !last;
+		const VLC_TABLE *t = random_entry(intra, last, room);
+		int run = t->event.run;
+
+		if (kind < 12) {
+			/* regular code */
+			BitstreamPutBits(bs, t->vlc.code, t->vlc.len);
+			BitstreamPutBits(bs, rand() & 1, 1);
+		} else if (kind == 12) {
+			/* escape mode 1, level offset */
+			BitstreamPutBits(bs, ESCAPE, 7);
+			BitstreamPutBits(bs, 0, 1);
+			BitstreamPutBits(bs, t->vlc.code, t->vlc.len);
+			BitstreamPutBits(bs, rand() & 1, 1);
+		} else if (kind == 13 &&
+				   run + max_run[intra][last][t->event.level] + 1 <= room) {
+			/* escape mode 2, run offset */
+			BitstreamPutBits(bs, ESCAPE, 7);
+			BitstreamPutBits(bs, 2, 2);
+			BitstreamPutBits(bs, t->vlc.code, t->vlc.len);
+			BitstreamPutBits(bs, rand() & 1, 1);
+			run += max_run[intra][last][t->event.level] + 1;
+		} else {
+			/* escape mode 3, fixed length */
+			int level = 1 + rand() % 2047;
+			if (rand() & 1)
+				level = -level;
+			BitstreamPutBits(bs, ESCAPE, 7);
+			BitstreamPutBits(bs, 3, 2);
+			BitstreamPutBits(bs, last, 1);
+			BitstreamPutBits(bs, run, 6);
+			BitstreamPutBits(bs, 1, 1);
+			BitstreamPutBits(bs, level & 0xfff, 12);
+			BitstreamPutBits(bs, 1, 1);
+		}
+
+		pos += run + 1;
+		if (last)
+			break;
+	}
+}
+
+static double
+now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* decodes all blocks, the last one into out so both decoders can be compared */
+static void
+decode_blocks(uint8_t *stream, size_t length, int blocks, int intra, int reference, int16_t *out)
+{
+	Bitstream bs;
+	DECLARE_ALIGNED_MATRIX(block, 1, 64, int16_t, CACHE_LINE);
+	const int quant = inter_quant;
+	int i;
+
+	BitstreamInit(&bs, stream, length);
+	for (i = 0; i < blocks; i++) {
+		int16_t *dst = out ? &out[i * 64] : block;
+		memset(dst, 0, 64 * sizeof(int16_t));
+		if (intra) {
+			if (reference)
+				reference_intra_block(&bs, dst);
+			else
+				get_intra_block(&bs, dst, 0, 0);
+		} else {
+			if (reference)
+				reference_inter_block_h263(&bs, dst, quant);
+			else
+				get_inter_block_h263(&bs, dst, 0, quant, NULL);
+		}
+	}
+}
+
+static int
+run_case(int intra, int blocks, int loops)
+{
+	/* escape mode 3 is the longest, 30 bits for each of at most 64 coefficients */
+	const size_t capacity = (size_t)blocks * 64 * 30 / 8 + 64;
+	uint8_t *stream = calloc(capacity, 1);
+	int16_t *expected = malloc((size_t)blocks * 64 * sizeof(int16_t));
+	int16_t *actual = malloc((size_t)blocks * 64 * sizeof(int16_t));
+	double best[2] = {1e30, 1e30};
+	Bitstream bs;
+	size_t length;
+	int i, l, mismatch = -1;
+
+	if (!stream || !expected || !actual) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	BitstreamInit(&bs, stream, 0);
+	for (i = 0; i < blocks; i++)
+		write_block(&bs, intra);
+	/* flush the last word and leave a zero word for the reader's look-ahead */
+	BitstreamPutBits(&bs, 0, 16);
+	BitstreamPutBits(&bs, 0, 16);
+	BitstreamPutBits(&bs, 0, 16);
+	BitstreamPutBits(&bs, 0, 16);
+	length = (size_t)((uint8_t*)bs.tail - stream);
+
+	decode_blocks(stream, length, blocks, intra, 1, expected);
+	decode_blocks(stream, length, blocks, intra, 0, actual);
+	for (i = 0; i < blocks && mismatch < 0; i++) {
+		if (memcmp(&expected[i * 64], &actual[i * 64], 64 * sizeof(int16_t)) != 0)
+			mismatch = i;
+	}
+
+	for (l = 0; l < loops; l++) {
+		int reference;
+		for (reference = 0; reference < 2; reference++) {
+			double t = now_seconds();
+			decode_blocks(stream, length, blocks, intra, reference, NULL);
+			t = now_seconds() - t;
+			if (t < best[reference])
+				best[reference] = t;
+		}
+	}
+
+	printf("%s: %d blocks, %zu bytes\n", intra ? "Intra" : "Inter", blocks, length);
+	printf("  reference tables: %.1f ns/block\n", best[1] * 1e9 / blocks);
+	printf("  packed tables:    %.1f ns/block (%.2fx)\n", best[0] * 1e9 / blocks, best[1] / best[0]);
+	if (mismatch >= 0)
+		printf("  MISMATCH in block %d\n", mismatch);
+
+	free(stream);
+	free(expected);
+	free(actual);
+	return mismatch >= 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	xvid_gbl_init_t init;
+	int blocks = argc > 1 ? atoi(argv[1]) : DEFAULT_BLOCKS;
+	int loops = argc > 2 ? atoi(argv[2]) : DEFAULT_LOOPS;
+	int failed = 0;
+
+	if (blocks <= 0 || loops <= 0) {
+		fprintf(stderr, "Usage: %s [blocks] [loops]\n", argv[0]);
+		return 2;
+	}
+
+	memset(&init, 0, sizeof(init));
+	init.version = XVID_VERSION;
+	xvid_global(NULL, XVID_GBL_INIT, &init, NULL);
+	init_reference_tables();
+
+	srand(1);
+	failed |= run_case(1, blocks, loops);
+	failed |= run_case(0, blocks, loops);
+
+	return failed;
+}
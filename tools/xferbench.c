@@ -0,0 +1,217 @@
+/*
+ * Host-side benchmark for the block transfer functions.
+ *
+ * Runs transfer_16to8add_dc and transfer8x8_copy, the C reference versions
+ * and the word-at-a-time ones the decoder uses, over the same blocks of a
+ * frame sized plane. The outputs have to be identical, the time per block is
+ * reported for each (and TSC cycles on x86).
+ *
+ * transfer_16to8add_dc gets the small DC residuals of typical inter blocks,
+ * which rarely leave 0..255, and large ones that clamp most pixels.
+ * transfer8x8_copy gets word aligned and misaligned sources, like whole and
+ * half-pel motion vectors.
+ *
+ * Usage: xferbench [blocks] [loops]
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "portab.h"
+#include "utils/mem_transfer.h"
+
+#define DEFAULT_BLOCKS 1584 /* a 352x288 picture */
+#define DEFAULT_LOOPS  200
+
+#define STRIDE 352
+
+static double
+now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t
+now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+typedef struct {
+	double seconds;
+	uint64_t cycles;
+} TIMING;
+
+static void
+keep_best(TIMING *best, double seconds, uint64_t cycles)
+{
+	if (seconds < best->seconds) {
+		best->seconds = seconds;
+		best->cycles = cycles;
+	}
+}
+
+static void
+report(const char *name, int blocks, const TIMING *reference, const TIMING *swar, int mismatch)
+{
+	printf("%s: %d blocks\n", name, blocks);
+	printf("  C reference: %6.1f ns/block", reference->seconds * 1e9 / blocks);
+	if (reference->cycles)
+		printf(", %6.1f cycles/block", (double)reference->cycles / blocks);
+	printf("\n  word-wise:   %6.1f ns/block", swar->seconds * 1e9 / blocks);
+	if (swar->cycles)
+		printf(", %6.1f cycles/block", (double)swar->cycles / blocks);
+	printf(" (%.2fx)\n", reference->seconds / swar->seconds);
+	if (mismatch >= 0)
+		printf("  MISMATCH in block %d\n", mismatch);
+}
+
+/* top left pixel of block i, the blocks cover the plane row by row */
+static size_t
+block_offset(int i)
+{
+	const int per_row = STRIDE / 8;
+	return (size_t)(i / per_row) * 8 * STRIDE + (size_t)(i % per_row) * 8;
+}
+
+static int
+run_add(const char *name, int blocks, int loops, int max_residual)
+{
+	const size_t plane_size = block_offset(blocks) + 8 * STRIDE;
+	uint8_t *plane = malloc(plane_size);
+	uint8_t *expected = malloc(plane_size);
+	uint8_t *actual = malloc(plane_size);
+	int16_t *values = malloc((size_t)blocks * sizeof(int16_t));
+	TIMING best[2] = {{1e30, 0}, {1e30, 0}};
+	int i, l, f, mismatch = -1;
+
+	if (!plane || !expected || !actual || !values) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < (int)plane_size; i++)
+		plane[i] = 16 + rand() % 220;
+	for (i = 0; i < blocks; i++)
+		values[i] = rand() % (2 * max_residual + 1) - max_residual;
+
+	memcpy(expected, plane, plane_size);
+	memcpy(actual, plane, plane_size);
+	for (i = 0; i < blocks; i++) {
+		transfer_16to8add_dc_c(expected + block_offset(i), values[i], STRIDE);
+		transfer_16to8add_dc_swar(actual + block_offset(i), values[i], STRIDE);
+		if (mismatch < 0 && memcmp(expected, actual, plane_size) != 0)
+			mismatch = i;
+	}
+
+	for (l = 0; l < loops; l++) {
+		for (f = 0; f < 2; f++) {
+			TRANSFER_16TO8DC *add = f ? transfer_16to8add_dc_swar : transfer_16to8add_dc_c;
+			double t;
+			uint64_t c;
+
+			/* from the same picture each time, so clamping stays as rare or common */
+			memcpy(actual, plane, plane_size);
+			t = now_seconds();
+			c = now_cycles();
+			for (i = 0; i < blocks; i++)
+				add(actual + block_offset(i), values[i], STRIDE);
+			c = now_cycles() - c;
+			keep_best(&best[f], now_seconds() - t, c);
+		}
+	}
+
+	report(name, blocks, &best[0], &best[1], mismatch);
+
+	free(plane);
+	free(expected);
+	free(actual);
+	free(values);
+	return mismatch >= 0;
+}
+
+static int
+run_copy(const char *name, int blocks, int loops, int misaligned)
+{
+	const size_t plane_size = block_offset(blocks) + 9 * STRIDE;
+	uint8_t *reference = malloc(plane_size);
+	uint8_t *expected = malloc(plane_size);
+	uint8_t *actual = malloc(plane_size);
+	int *offsets = malloc((size_t)blocks * sizeof(int));
+	TIMING best[2] = {{1e30, 0}, {1e30, 0}};
+	int i, l, f, mismatch = -1;
+
+	if (!reference || !expected || !actual || !offsets) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < (int)plane_size; i++)
+		reference[i] = rand();
+	/* a vector of up to one pixel right, the plane has a row to spare below */
+	for (i = 0; i < blocks; i++)
+		offsets[i] = misaligned ? 1 + rand() % 3 : 0;
+
+	memset(expected, 0, plane_size);
+	memset(actual, 0, plane_size);
+	for (i = 0; i < blocks; i++) {
+		transfer8x8_copy_c(expected + block_offset(i), reference + block_offset(i) + offsets[i], STRIDE);
+		transfer8x8_copy_swar(actual + block_offset(i), reference + block_offset(i) + offsets[i], STRIDE);
+		if (mismatch < 0 && memcmp(expected, actual, plane_size) != 0)
+			mismatch = i;
+	}
+
+	for (l = 0; l < loops; l++) {
+		for (f = 0; f < 2; f++) {
+			TRANSFER8X8_COPY *copy = f ? transfer8x8_copy_swar : transfer8x8_copy_c;
+			double t = now_seconds();
+			uint64_t c = now_cycles();
+			for (i = 0; i < blocks; i++)
+				copy(actual + block_offset(i), reference + block_offset(i) + offsets[i], STRIDE);
+			c = now_cycles() - c;
+			keep_best(&best[f], now_seconds() - t, c);
+		}
+	}
+
+	report(name, blocks, &best[0], &best[1], mismatch);
+
+	free(reference);
+	free(expected);
+	free(actual);
+	free(offsets);
+	return mismatch >= 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	int blocks = argc > 1 ? atoi(argv[1]) : DEFAULT_BLOCKS;
+	int loops = argc > 2 ? atoi(argv[2]) : DEFAULT_LOOPS;
+	int failed = 0;
+
+	if (blocks <= 0 || loops <= 0) {
+		fprintf(stderr, "Usage: %s [blocks] [loops]\n", argv[0]);
+		return 2;
+	}
+
+	srand(1);
+	failed |= run_add("transfer_16to8add_dc, residuals up to 24", blocks, loops, 24);
+	failed |= run_add("transfer_16to8add_dc, residuals up to 2047", blocks, loops, 2047);
+	failed |= run_copy("transfer8x8_copy, aligned source", blocks, loops, 0);
+	failed |= run_copy("transfer8x8_copy, misaligned source", blocks, loops, 1);
+
+	return failed;
+}